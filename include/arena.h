@@ -0,0 +1,105 @@
+/**
+ * @file arena.h
+ * @brief Bump-pointer allocation for objects that die together
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace compiler {
+
+/**
+ * @class arena_t
+ * @brief Hands out memory from large blocks and frees it all at once
+ *
+ * An allocation only moves a pointer forward; a new block is taken from the
+ * heap when the current one is full. Nothing is freed individually, every
+ * block goes away with release() or the arena, so the arena is meant to be
+ * owned by whatever owns the objects' lifetime, e.g. one compilation unit.
+ * Destructors are never run, only trivially destructible types can be
+ * created in it.
+ */
+class arena_t {
+public:
+  /// @brief Size of the blocks taken from the heap
+  static constexpr size_t default_block_size = 64 * 1024;
+
+  /**
+   * @brief Creates an empty arena, no memory is taken until first use
+   * @param block_size Size of the blocks taken from the heap
+   */
+  explicit arena_t(size_t block_size = default_block_size);
+
+  arena_t(const arena_t &) = delete;
+  arena_t &operator=(const arena_t &) = delete;
+
+  /**
+   * @brief Allocates uninitialized memory
+   * @param size Number of bytes
+   * @param alignment Alignment of the memory, a power of two
+   * @return Memory valid until release()
+   */
+  void *allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+    uintptr_t p = reinterpret_cast<uintptr_t>(this->_p_next);
+    uintptr_t aligned = (p + alignment - 1) & ~(uintptr_t(alignment) - 1);
+    if (this->_p_next == nullptr ||
+        aligned + size > reinterpret_cast<uintptr_t>(this->_p_end)) {
+      return this->allocate_slow(size, alignment);
+    }
+    this->_p_next = reinterpret_cast<char *>(aligned + size);
+    this->_size += size;
+    return reinterpret_cast<void *>(aligned);
+  }
+
+  /**
+   * @brief Constructs an object in the arena
+   * @param args Constructor arguments
+   * @return The object, valid until release()
+   */
+  template <typename T, typename... Args> T *create(Args &&...args) {
+    static_assert(std::is_trivially_destructible<T>::value,
+                  "the arena never runs destructors");
+    return new (this->allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief Copies a string into the arena
+   * @param text The string
+   * @return View of the copy, valid until release()
+   */
+  std::string_view copy(std::string_view text);
+
+  /**
+   * @brief Frees every block, all memory handed out becomes invalid
+   */
+  void release();
+
+  /**
+   * @brief Gets the number of bytes handed out since the last release()
+   * @return Bytes allocated, without alignment padding
+   */
+  size_t size() const { return _size; }
+
+private:
+  void *allocate_slow(size_t size, size_t alignment);
+
+  std::vector<std::unique_ptr<char[]>> _blocks;
+  char *_p_next;
+  char *_p_end;
+  size_t _block_size;
+  size_t _size;
+};
+
+} // namespace compiler
+
+#endif /* end of include guard: ARENA_H */
@@ -7,14 +7,15 @@
  */
 
 #include "code_generation/ast_visitor_interface.h"
+#include "interner.h"
 #include "parser/abstract_syntax_tree.h"
 #include "tokens.h"
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Value.h>
-#include <map>
 #include <string>
+#include <unordered_map>
 
 namespace compiler::ast {
 
@@ -149,7 +150,7 @@ private:
   std::unique_ptr<llvm::LLVMContext> context;
   std::unique_ptr<llvm::IRBuilder<>> builder;
   std::unique_ptr<llvm::Module> module;
-  std::map<std::string, llvm::AllocaInst *> named_values;
+  std::unordered_map<symbol_id_t, llvm::AllocaInst *> named_values;
 
   llvm::Value *last_value;
   llvm::Function *current_function;
@@ -0,0 +1,103 @@
+/**
+ * @file diagnostics.h
+ * @brief Bounded collection of errors found in a source
+ */
+
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace compiler {
+
+/**
+ * @struct diagnostic_t
+ * @brief One error, located by the bytes it concerns
+ */
+struct diagnostic_t {
+  uint32_t offset; ///< first byte, see line_index_t for line and column
+  uint32_t length; ///< number of bytes
+  std::string message;
+};
+
+/**
+ * @class diagnostics_t
+ * @brief Collects diagnostics up to a limit and counts the rest
+ *
+ * A broken input can produce an error for almost every byte. Only the first
+ * few are kept, the others are just counted, so neither memory nor the
+ * report grows with the amount of garbage in a file.
+ */
+class diagnostics_t {
+public:
+  /// @brief Number of diagnostics kept by default
+  static constexpr size_t default_limit = 100;
+
+  /**
+   * @brief Constructs an empty collection
+   * @param limit Number of diagnostics to keep
+   */
+  explicit diagnostics_t(size_t limit = default_limit);
+
+  /**
+   * @brief Adds a diagnostic, or counts it once the limit is reached
+   * @param offset First byte the diagnostic concerns
+   * @param length Number of bytes it concerns
+   * @param message Description of the error
+   */
+  void report(uint32_t offset, uint32_t length, std::string message);
+
+  /**
+   * @brief Appends the diagnostics of another collection
+   * @param other Diagnostics of a later part of the same source
+   */
+  void merge(const diagnostics_t &other);
+
+  /**
+   * @brief Orders the kept diagnostics by offset
+   *
+   * Diagnostics at the same offset keep the order they were reported in.
+   */
+  void sort();
+
+  /**
+   * @brief Removes all diagnostics
+   */
+  void clear();
+
+  /**
+   * @brief Gets the diagnostics that were kept, in the order reported
+   * @return At most limit() diagnostics
+   */
+  const std::vector<diagnostic_t> &entries() const;
+
+  /**
+   * @brief Gets the number of diagnostics that did not fit
+   * @return Diagnostics reported beyond the limit
+   */
+  size_t dropped() const;
+
+  /**
+   * @brief Checks whether anything was reported
+   * @return true if no diagnostic was reported
+   */
+  bool empty() const;
+
+  /**
+   * @brief Gets the number of diagnostics kept at most
+   * @return The limit given at construction
+   */
+  size_t limit() const;
+
+private:
+  size_t _limit;
+  std::vector<diagnostic_t> _entries;
+  size_t _dropped;
+};
+
+} // namespace compiler
+
+#endif /* end of include guard: DIAGNOSTICS_H */
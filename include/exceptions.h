@@ -2,10 +2,12 @@
 #define EXCEPTIONS_H
 
 // #include "spdlog/fmt/fmt.h"
+#include "line_index.h"
 #include "parser/abstract_syntax_tree.h"
 #include "spdlog/fmt/bundled/format.h"
 #include "tokens.h"
 #include <exception>
+#include <optional>
 #include <string>
 
 namespace compiler {
@@ -15,20 +17,43 @@ class syntax_error : public std::exception {
 public:
   syntax_error(std::string msg) {
     this->msg = msg;
-    this->p_tok = nullptr;
     this->formatted_msg = fmt::format("Syntax error: {}", this->msg);
   }
-  syntax_error(std::string msg, token_t *p_tok) {
+  syntax_error(std::string msg, const token_t &tok) {
     this->msg = msg;
-    this->p_tok = p_tok;
+    this->tok = tok;
     this->formatted_msg =
-        fmt::format("Syntax error at line:{}: {}: {}", this->p_tok->linenumber,
-                    this->p_tok->t_val, this->msg);
+        this->format_at(fmt::format("offset:{}", this->tok->offset));
   }
+  syntax_error(std::string msg, token_t *p_tok) : syntax_error(msg, *p_tok) {}
   virtual const char *what() const noexcept { return formatted_msg.c_str(); }
 
+  /// @brief Gets the description of the error, without its position
+  const std::string &message() const { return this->msg; }
+
+  /// @brief Gets the token the error was found at, if known
+  const std::optional<token_t> &token() const { return this->tok; }
+
+  /**
+   * @brief Replaces the byte offset in the message by line and column
+   * @param lines Index of the source the token was lexed from
+   */
+  void locate(const line_index_t &lines) {
+    if (!this->tok) {
+      return;
+    }
+    source_location_t loc = lines.locate(this->tok->offset);
+    this->formatted_msg =
+        this->format_at(fmt::format("line:{}:{}", loc.line, loc.column));
+  }
+
 protected:
-  token_t *p_tok;
+  virtual std::string format_at(const std::string &position) const {
+    return fmt::format("Syntax error at {}: {}: {}", position, this->tok->t_val,
+                       this->msg);
+  }
+
+  std::optional<token_t> tok;
   std::string msg;
   std::string formatted_msg;
 };
@@ -36,6 +61,7 @@ protected:
 class parser_error : public syntax_error {
 public:
   parser_error(std::string msg) : syntax_error(msg) {};
+  parser_error(std::string msg, const token_t &tok) : syntax_error(msg, tok) {};
   parser_error(std::string msg, token_t *p_tok) : syntax_error(msg, p_tok) {};
 };
 
@@ -44,12 +70,19 @@ public:
   variable_not_declared_error(std::string msg) : syntax_error(msg) {
     this->formatted_msg = fmt::format("Varable is not declared: {}", this->msg);
   };
-  variable_not_declared_error(std::string msg, token_t *p_tok)
-      : syntax_error(msg, p_tok) {
+  variable_not_declared_error(std::string msg, const token_t &tok)
+      : syntax_error(msg, tok) {
     this->formatted_msg =
-        fmt::format("Varable is not declared: {}: {}: {}",
-                    this->p_tok->linenumber, this->p_tok->t_val, this->msg);
+        this->format_at(fmt::format("offset:{}", this->tok->offset));
   };
+  variable_not_declared_error(std::string msg, token_t *p_tok)
+      : variable_not_declared_error(msg, *p_tok) {};
+
+protected:
+  std::string format_at(const std::string &position) const override {
+    return fmt::format("Varable is not declared: {}: {}: {}", position,
+                       this->tok->t_val, this->msg);
+  }
 };
 
 class variable_already_declared_error : public syntax_error {
@@ -57,12 +90,19 @@ public:
   variable_already_declared_error(std::string msg) : syntax_error(msg) {
     this->formatted_msg = fmt::format("Varable is not declared: {}", this->msg);
   };
-  variable_already_declared_error(std::string msg, token_t *p_tok)
-      : syntax_error(msg, p_tok) {
+  variable_already_declared_error(std::string msg, const token_t &tok)
+      : syntax_error(msg, tok) {
     this->formatted_msg =
-        fmt::format("Varable is not declared: {}: {}: {}",
-                    this->p_tok->linenumber, this->p_tok->t_val, this->msg);
+        this->format_at(fmt::format("offset:{}", this->tok->offset));
   };
+  variable_already_declared_error(std::string msg, token_t *p_tok)
+      : variable_already_declared_error(msg, *p_tok) {};
+
+protected:
+  std::string format_at(const std::string &position) const override {
+    return fmt::format("Varable is not declared: {}: {}: {}", position,
+                       this->tok->t_val, this->msg);
+  }
 };
 
 } // namespace exceptions
@@ -0,0 +1,74 @@
+/**
+ * @file interner.h
+ * @brief Maps identifier spellings to dense integer IDs
+ */
+
+#ifndef INTERNER_H
+#define INTERNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace compiler {
+
+/// @brief Dense ID of an interned spelling
+using symbol_id_t = uint32_t;
+
+/// @brief Symbol of tokens that are not identifiers
+constexpr symbol_id_t no_symbol = UINT32_MAX;
+
+/**
+ * @class interner_t
+ * @brief Assigns every distinct spelling one symbol_id_t
+ *
+ * The lexer interns each identifier once, every later stage compares and
+ * looks up the 32-bit IDs instead of hashing strings again. IDs are handed
+ * out in order starting at 0 and stay valid for the lifetime of the
+ * interner. All members may be called concurrently.
+ */
+class interner_t {
+public:
+  interner_t() = default;
+  interner_t(const interner_t &) = delete;
+  interner_t &operator=(const interner_t &) = delete;
+
+  /**
+   * @brief Gets the ID of a spelling, adding it if it is new
+   * @param t_spelling The spelling, copied on first sight
+   * @return ID of the spelling
+   */
+  symbol_id_t intern(std::string_view t_spelling);
+
+  /**
+   * @brief Gets the spelling of an ID
+   * @param id An ID returned by intern()
+   * @return The spelling, valid as long as the interner
+   */
+  const std::string &spelling(symbol_id_t id);
+
+  /**
+   * @brief Gets the number of distinct spellings
+   * @return Number of IDs handed out
+   */
+  size_t size();
+
+  /**
+   * @brief Gets the interner shared by the whole compiler
+   * @return Interner created on first use
+   */
+  static interner_t &global();
+
+private:
+  std::mutex _mutex;
+  std::deque<std::string> _spellings; ///< deque keeps the keys' storage
+  std::unordered_map<std::string_view, symbol_id_t> _ids;
+};
+
+} // namespace compiler
+
+#endif /* end of include guard: INTERNER_H */
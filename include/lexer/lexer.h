@@ -6,19 +6,71 @@
 #ifndef LEXER_H
 #define LEXER_H
 
+#include "diagnostics.h"
+#include "interner.h"
+#include "lexer/scan_kernels.h"
+#include "lexer/token_cache.h"
+#include "source_buffer.h"
+#include "source_stream.h"
+#include "thread_pool.h"
+#include "token_buffer.h"
 #include "tokens.h"
+#include <cstddef>
+#include <cstdint>
 #include <string>
-#include <vector>
+#include <string_view>
+#include <unordered_map>
 
 namespace compiler {
 namespace lexer {
 
+/**
+ * @struct source_edit_t
+ * @brief One replacement of a byte range in a source
+ */
+struct source_edit_t {
+  size_t offset;          ///< first changed byte, same in old and new source
+  size_t removed_length;  ///< bytes of the old source that were replaced
+  size_t inserted_length; ///< bytes of the new source that replaced them
+};
+
+/**
+ * @struct token_diff_t
+ * @brief Tokens that changed between two token streams
+ *
+ * Tokens [first, first + removed) of the old stream were replaced by tokens
+ * [first, first + inserted) of the new one. All other tokens are equal up to
+ * a shift of their offset.
+ */
+struct token_diff_t {
+  token_index_t first;
+  token_index_t removed;
+  token_index_t inserted;
+};
+
 /**
  * @class lexer_t
  * @brief Performs lexical analysis on source code strings
  *
  * Tokenizes source code by scanning through the input and identifying
  * lexical tokens such as keywords, operators, identifiers, and literals.
+ * The lexer never copies the input; it advances a byte offset through the
+ * source it was given and the tokens it returns point back into that source.
+ * Lines are not tracked while lexing, see line_index_t. Numeric literals are
+ * decoded and identifiers interned into interner_t::global() as they are
+ * scanned; every lexer keeps a cache of the spellings it has seen so parallel
+ * lexers rarely contend for the shared interner.
+ *
+ * Bytes that start no token are returned as tok_error and lexing continues
+ * behind them. Errors are collected in diagnostics() instead of being
+ * printed, the caller reports them once.
+ *
+ * Tokens can either be lexed all at once with lex() or pulled one at a time
+ * with next_token() and peek(). The pull interface only keeps a small ring of
+ * lookahead tokens, so memory does not grow with the length of the input.
+ * Fed from a source_stream_t the lexer does not even need the whole source:
+ * it lexes the complete lines of a rolling buffer and reads the next chunk
+ * once they are used up, dropping the bytes no token refers to any more.
  */
 class lexer_t {
 public:
@@ -27,32 +79,146 @@ public:
    */
   lexer_t();
 
+  /**
+   * @brief Constructs a lexer that streams the tokens of a source
+   * @param source The source code to tokenize, must outlive the tokens
+   * @throws std::runtime_error if the source exceeds 4 GiB
+   */
+  explicit lexer_t(std::string_view source);
+
+  /**
+   * @brief Constructs a lexer that streams the tokens of an input stream
+   * @param stream The input, read on demand, must outlive the lexer
+   *
+   * Only next_token() and peek() may be used. The lexeme of a token stays
+   * valid until the next call to either of them, offsets count from the
+   * start of the stream.
+   */
+  explicit lexer_t(source_stream_t &stream);
+
   /**
    * @brief Tokenizes the provided source code string
-   * @param source The source code to tokenize
-   * @return A vector of tokens extracted from the source
+   * @param source The source code to tokenize, must outlive the tokens
+   * @return The tokens extracted from the source
+   * @throws std::runtime_error if the source exceeds 4 GiB
+   */
+  token_buffer_t lex(std::string_view source);
+
+  /**
+   * @brief Tokenizes part of a source
+   * @param source The complete source, offsets of the tokens refer to it
+   * @param first Offset of the first byte to lex
+   * @param last Offset one past the last byte to lex, must not split a token
+   * @return The tokens in [first, last) followed by tok_eof
+   * @throws std::runtime_error if the source exceeds 4 GiB
+   */
+  token_buffer_t lex_range(std::string_view source, size_t first,
+                           size_t last);
+
+  /**
+   * @brief Updates a token stream after an edit of its source
+   * @param previous Tokens of the source before the edit
+   * @param source The source after the edit, must outlive the tokens
+   * @param edit The byte range that changed
+   * @param p_diff Receives the tokens that changed, may be nullptr
+   * @return The tokens of the edited source, equal to lex(source)
+   * @throws std::out_of_range if the edit lies outside the source
+   *
+   * Lexing restarts at the line of the edit and stops as soon as a new token
+   * starts where a token of the previous stream started, because from there
+   * on both streams are the same. The work grows with the size of the edit,
+   * tokens after it are only shifted.
+   */
+  token_buffer_t relex(token_buffer_t previous, std::string_view source,
+                       const source_edit_t &edit, token_diff_t *p_diff);
+
+  /**
+   * @brief Pulls the next token from the source
+   * @return The next token, tok_eof once the source is exhausted
+   */
+  token_t next_token();
+
+  /**
+   * @brief Looks ahead without consuming
+   * @param k Number of tokens to skip, 0 is the token next_token() returns
+   * @return The k-th upcoming token, valid until the next call to next_token()
+   */
+  const token_t &peek(size_t k = 0);
+
+  /**
+   * @brief Gets the byte offset of the cursor into the source
+   * @return Offset of the next byte the lexer will look at, counted from the
+   * start of the stream when streaming
    */
-  std::vector<token_t *> lex(std::string source);
+  size_t get_offset();
 
   /**
-   * @brief Gets the current line number during lexical analysis
-   * @return The current line number being processed
+   * @brief Gets the errors found in the tokens scanned so far
+   * @return Diagnostics since the last call to lex(), lex_range() or relex()
+   *
+   * relex() only reports errors of the tokens it scanned again.
    */
-  int get_linenumber();
+  const diagnostics_t &diagnostics() const;
+
+  /// @brief Number of tokens peek() can look ahead
+  static constexpr size_t max_lookahead = 8;
 
 private:
-  std::vector<token_t *> _t_tokens;
-  std::string _t_source;
-  int current_linenumber;
+  token_e scan(uint32_t *offset, uint32_t *length);
+  token_value_t decode(token_e kind, uint32_t offset, uint32_t length);
+  void set_source(std::string_view source);
+  bool refill();
+
+  std::string_view _t_source;
+  size_t current_offset;
+  const scan_kernels_t *_p_kernels;
+  std::unordered_map<std::string_view, symbol_id_t> _symbol_cache;
+  diagnostics_t _diagnostics;
+
+  // rolling buffer of a source_stream_t, _t_source views its complete lines
+  source_stream_t *_p_stream;
+  std::string _t_window;
+  size_t _window_offset; ///< offset of the window's first byte in the stream
+
+  // lookahead ring of the streaming interface
+  token_t _ring[max_lookahead];
+  size_t _ring_head;
+  size_t _ring_size;
 };
 
+/// @brief Sources at least this large are lexed by lex_file in parallel
+constexpr size_t parallel_lex_threshold = 4 * 1024 * 1024;
+
 /**
- * @brief Reads and tokenizes a source file
- * @param t_input_file_path Path to the source file to lex
- * @return A vector of tokens extracted from the file
- * @throws std::runtime_error if the file cannot be opened or read
+ * @brief Tokenizes a source on several threads
+ * @param source The source code to tokenize, must outlive the tokens
+ * @param pool Threads to lex on
+ * @param n_chunks Number of pieces to split the source into
+ * @param p_diagnostics Receives the errors in source order, may be nullptr
+ * @return Exactly the tokens lexer_t::lex would return
+ * @throws std::runtime_error if the source exceeds 4 GiB
+ *
+ * The source is split after newlines, the pieces are lexed independently
+ * and their token streams concatenated.
+ */
+token_buffer_t lex_parallel(std::string_view source, thread_pool_t &pool,
+                            size_t n_chunks,
+                            diagnostics_t *p_diagnostics = nullptr);
+
+/**
+ * @brief Tokenizes a loaded source file
+ * @param t_source Buffer holding the file, must outlive the tokens
+ * @param p_diagnostics Receives the errors in the file, may be nullptr
+ * @param p_cache Cache to look the tokens up in and add them to, may be
+ * nullptr
+ * @return The tokens extracted from the file
+ *
+ * Files of parallel_lex_threshold bytes or more are lexed with lex_parallel
+ * on the shared thread pool. Files with errors are never cached.
  */
-std::vector<token_t *> lex_file(std::string t_input_file_path);
+token_buffer_t lex_file(const source_buffer_t &t_source,
+                        diagnostics_t *p_diagnostics = nullptr,
+                        const token_cache_t *p_cache = nullptr);
 
 } // namespace lexer
 } // namespace compiler
@@ -0,0 +1,83 @@
+/**
+ * @file scan_kernels.h
+ * @brief Vectorized byte scanning loops used by the lexer
+ */
+
+#ifndef SCAN_KERNELS_H
+#define SCAN_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace compiler {
+namespace lexer {
+
+/**
+ * @struct scan_kernels_t
+ * @brief Set of scanning loops for one instruction set
+ *
+ * Every kernel reads only bytes in [p, end) and returns a pointer into that
+ * range, end if the scanned run reaches the end of the input.
+ */
+struct scan_kernels_t {
+  /// @brief Name of the instruction set, e.g. "avx2"
+  const char *name;
+
+  /**
+   * @brief Skips spaces, tabs and newlines
+   * @return First byte that is not whitespace
+   */
+  const char *(*skip_whitespace)(const char *p, const char *end);
+
+  /**
+   * @brief Skips identifier characters [A-Za-z0-9_]
+   * @return First byte that can not continue an identifier
+   */
+  const char *(*skip_identifier)(const char *p, const char *end);
+
+  /**
+   * @brief Finds the end of a line comment
+   * @return First '\n' or '\r'
+   */
+  const char *(*find_line_end)(const char *p, const char *end);
+
+  /**
+   * @brief Counts line feeds
+   * @return Number of '\n' in [p, end)
+   */
+  size_t (*count_newlines)(const char *p, const char *end);
+
+  /**
+   * @brief Collects the offsets of line feeds
+   * @param base Offset of p, added to every collected position
+   * @param p_out Receives one offset per '\n', has room for
+   *              count_newlines(p, end) entries
+   * @return Number of offsets written
+   */
+  size_t (*find_newlines)(const char *p, const char *end, uint32_t base,
+                          uint32_t *p_out);
+};
+
+/**
+ * @brief Gets the portable byte-at-a-time kernels
+ * @return The scalar kernels
+ */
+const scan_kernels_t &scalar_scan_kernels();
+
+/**
+ * @brief Gets the fastest kernels the running CPU supports
+ * @return AVX2, SSE2 or scalar kernels, decided once on first call
+ */
+const scan_kernels_t &scan_kernels();
+
+/**
+ * @brief Gets every kernel set the running CPU can execute
+ * @return The kernel sets, scalar first
+ */
+std::vector<const scan_kernels_t *> supported_scan_kernels();
+
+} // namespace lexer
+} // namespace compiler
+
+#endif /* end of include guard: SCAN_KERNELS_H */
@@ -0,0 +1,68 @@
+/**
+ * @file line_index.h
+ * @brief Maps byte offsets in a source to lines and columns
+ */
+
+#ifndef LINE_INDEX_H
+#define LINE_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace compiler {
+
+/**
+ * @struct source_location_t
+ * @brief Human readable position in a source, both counted from 1
+ */
+struct source_location_t {
+  uint32_t line;
+  uint32_t column; ///< in bytes
+};
+
+/**
+ * @class line_index_t
+ * @brief Table of line starts of one source
+ *
+ * Tokens only carry byte offsets. Whoever has to show a position to a user
+ * builds the index once, with a vector scan for the line feeds, and looks
+ * offsets up with a binary search. The lexer itself never counts lines.
+ */
+class line_index_t {
+public:
+  /**
+   * @brief Builds the index of a source
+   * @param source The source code, only read during construction
+   * @throws std::runtime_error if the source exceeds 4 GiB
+   */
+  explicit line_index_t(std::string_view source);
+
+  /**
+   * @brief Finds the line and column of a byte
+   * @param offset Byte offset into the source, may be the source length
+   * @return Location of the byte
+   */
+  source_location_t locate(uint32_t offset) const;
+
+  /**
+   * @brief Gets the number of lines
+   * @return Number of line feeds plus one
+   */
+  size_t line_count() const { return _line_starts.size(); }
+
+  /**
+   * @brief Gets the offset a line starts at
+   * @param line Line number, counted from 1
+   * @return Offset of the first byte of the line
+   */
+  uint32_t line_start(uint32_t line) const { return _line_starts[line - 1]; }
+
+private:
+  std::vector<uint32_t> _line_starts;
+};
+
+} // namespace compiler
+
+#endif /* end of include guard: LINE_INDEX_H */
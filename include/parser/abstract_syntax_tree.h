@@ -11,20 +11,84 @@
 #ifndef ABSTRACT_SYNTAX_TREE_H
 #define ABSTRACT_SYNTAX_TREE_H
 
+#include "arena.h"
 #include "code_generation/ast_visitor_interface.h"
+#include "interner.h"
+#include "token_buffer.h"
 #include "tokens.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
 #include <string>
+#include <string_view>
 #include <tuple>
+#include <type_traits>
 #include <variant>
-#include <vector>
 
 namespace compiler {
+namespace symbol_table {
+class symbol_table_t;
+} // namespace symbol_table
+
 namespace parser {
 namespace ast {
 namespace node {
 
 using namespace compiler::ast;
 
+/**
+ * @class node_list_t
+ * @brief Growable array of node children, kept in the tree's arena
+ * @tparam T Trivially destructible item type, usually a node pointer
+ *
+ * Takes the place of std::vector in nodes, which would need a destructor.
+ * Growing copies the items into a twice as large array, the old one is only
+ * reclaimed together with the arena.
+ */
+template <typename T> class node_list_t {
+  static_assert(std::is_trivially_destructible<T>::value,
+                "the arena never runs destructors");
+
+public:
+  /**
+   * @brief Appends an item
+   * @param arena Arena of the tree the list belongs to
+   * @param item The item
+   */
+  void push_back(arena_t &arena, const T &item) {
+    if (this->_size == this->_capacity) {
+      this->grow(arena);
+    }
+    new (&this->_p_items[this->_size++]) T(item);
+  }
+
+  size_t size() const { return this->_size; }
+  bool empty() const { return this->_size == 0; }
+  T &operator[](size_t i) { return this->_p_items[i]; }
+  const T &operator[](size_t i) const { return this->_p_items[i]; }
+  T *begin() { return this->_p_items; }
+  T *end() { return this->_p_items + this->_size; }
+  const T *begin() const { return this->_p_items; }
+  const T *end() const { return this->_p_items + this->_size; }
+
+private:
+  void grow(arena_t &arena) {
+    uint32_t capacity = this->_capacity == 0 ? 4 : 2 * this->_capacity;
+    T *p_items =
+        static_cast<T *>(arena.allocate(capacity * sizeof(T), alignof(T)));
+    for (uint32_t i = 0; i < this->_size; i++) {
+      new (&p_items[i]) T(this->_p_items[i]);
+    }
+    this->_p_items = p_items;
+    this->_capacity = capacity;
+  }
+
+  T *_p_items = nullptr;
+  uint32_t _size = 0;
+  uint32_t _capacity = 0;
+};
+
 /**
  * @class node_t
  * @brief Base class for all AST nodes
@@ -35,9 +99,10 @@ using namespace compiler::ast;
 class node_t {
 protected:
   node_t() = default;
+  // nodes are never deleted, the arena of their tree frees them
+  ~node_t() = default;
 
 public:
-  virtual ~node_t() = default;
 
   /**
    * @brief Generates a debug string representation of the node
@@ -64,7 +129,6 @@ protected:
   statement_t() = default;
 
 public:
-  virtual ~statement_t() = default;
   virtual std::string debug_print() const = 0;
   virtual void accept_visitor(visitor_t *visitor) = 0;
 };
@@ -80,7 +144,6 @@ class expression_t : public node_t {
 
 public:
   expression_t() = default;
-  virtual ~expression_t() = default;
 
   /**
    * @brief Converts the expression to prefix notation
@@ -115,7 +178,6 @@ public:
 class if_t : public statement_t {
 public:
   if_t(expression_t *p_expr, statement_t *p_statement);
-  ~if_t();
 
   expression_t *p_expr; ///< Condition expression
   statement_t *p_stmt;  ///< Statement to execute if condition is true
@@ -133,7 +195,6 @@ public:
 class else_t : public statement_t {
 public:
   else_t(statement_t *p_statement);
-  ~else_t();
 
   statement_t *p_stmt; ///< Statement to execute in else branch
 
@@ -151,7 +212,6 @@ class for_t : public statement_t {
 public:
   for_t(statement_t *p_first, expression_t *p_expr, statement_t *p_last,
         block_t *p_block);
-  ~for_t();
   virtual std::string debug_print() const;
   virtual void accept_visitor(visitor_t *visitor) { visitor->visit_for(this); }
 
@@ -172,7 +232,6 @@ public:
 class while_t : public statement_t {
 public:
   while_t(expression_t *p_expr, statement_t *p_statement);
-  ~while_t();
 
   expression_t *p_expr; ///< Loop condition expression
   statement_t *p_stmt;  ///< Loop body statement
@@ -193,7 +252,6 @@ public:
 class do_t : public statement_t {
 public:
   do_t(expression_t *p_expr, statement_t *p_statement);
-  ~do_t();
 
   expression_t *p_expr; ///< Loop condition expression
   statement_t *p_stmt;  ///< Loop body statement
@@ -211,7 +269,6 @@ public:
 class return_t : public statement_t {
 public:
   return_t(expression_t *p_expr);
-  ~return_t();
 
   expression_t *p_expr; ///< Expression to return
 
@@ -231,7 +288,7 @@ class block_t : public statement_t {
 public:
   block_t() = default;
 
-  std::vector<statement_t *> statements; ///< Statements within the block
+  node_list_t<statement_t *> statements; ///< Statements within the block
 
   virtual std::string debug_print() const;
   virtual void accept_visitor(visitor_t *visitor) {
@@ -239,32 +296,56 @@ public:
   }
 };
 
+/**
+ * @struct deferred_body_t
+ * @brief Where to find a function body that was not parsed yet
+ */
+struct deferred_body_t {
+  const token_buffer_t *p_tokens; ///< Tokens of the source, outlive the tree
+  size_t first;                   ///< Index of the opening {
+  size_t end;                     ///< Index after the closing }
+  symbol_table::symbol_table_t *p_scope; ///< Scope of the parameters
+  arena_t *p_arena;                      ///< Arena of the function's tree
+};
+
 /**
  * @class function_t
  * @brief Represents a function definition
  *
- * Contains the function's return type, name, parameters, and body.
+ * Contains the function's return type, name, parameters, and body. The body
+ * of a function from parser::parse_declarations is only parsed when body()
+ * is first called, so read it through body() rather than block.
  */
 class function_t : public node_t {
 public:
   function_t(
-      token_e type, int pointer_level, std::string identifier,
-      std::vector<std::tuple<token_e, int>> *parameter_type_pointer_level_tuple,
+      token_e type, int pointer_level, symbol_id_t identifier,
+      node_list_t<std::tuple<token_e, int>> *parameter_type_pointer_level_tuple,
       block_t *block);
-  ~function_t();
   virtual std::string debug_print() const;
   virtual void accept_visitor(visitor_t *visitor) {
     visitor->visit_function(this);
   }
 
+  /**
+   * @brief Gets the body, parsing it first if that was deferred
+   * @return The body
+   * @throws exceptions::syntax_error if the deferred body does not parse
+   *
+   * Parsing a deferred body is not thread safe for the same function.
+   */
+  block_t *body() const;
+
 public:
   token_e type;      ///< Return type
   int pointer_level; ///< Number of pointer indirections for return type
-  std::vector<std::tuple<token_e, int>>
+  node_list_t<std::tuple<token_e, int>>
       *parameter_type_pointer_level_tuple; ///< Parameter types and pointer
                                            ///< levels
-  block_t *block;                          ///< Function body
-  std::string identifier;                  ///< Function name
+  mutable block_t *block;                  ///< Function body
+  symbol_id_t identifier;                  ///< Function name
+  /// Set until the body is parsed by body()
+  mutable deferred_body_t *p_deferred_body = nullptr;
 };
 
 /**
@@ -276,10 +357,9 @@ public:
  */
 class variable_t : public statement_t {
 public:
-  variable_t(token_e type, int pointer_level, std::string identifier,
+  variable_t(token_e type, int pointer_level, symbol_id_t identifier,
              expression_t *p_expr, bool is_const = false,
              bool is_static = false);
-  ~variable_t();
   virtual std::string debug_print() const;
   virtual void accept_visitor(visitor_t *visitor) {
     visitor->visit_variable(this);
@@ -288,7 +368,7 @@ public:
 public:
   token_e type;           ///< Variable type
   int pointer_level;      ///< Number of pointer indirections
-  std::string identifier; ///< Variable name
+  symbol_id_t identifier; ///< Variable name
   expression_t *p_expr;   ///< Initialization expression (can be null)
   bool is_const;          ///< Whether variable is declared const
   bool is_static;         ///< Whether variable is declared static
@@ -302,9 +382,8 @@ public:
  */
 class assign_expr_t : public statement_t {
 public:
-  assign_expr_t(std::string identifier, expression_t *right)
+  assign_expr_t(symbol_id_t identifier, expression_t *right)
       : identifier(identifier), right(right) {}
-  ~assign_expr_t() { delete right; }
   virtual std::string to_prefix_notation() const;
   virtual std::string debug_print() const;
   virtual void accept_visitor(visitor_t *visitor) {
@@ -312,7 +391,7 @@ public:
   }
 
 public:
-  std::string identifier; ///< Variable being assigned to
+  symbol_id_t identifier; ///< Variable being assigned to
   expression_t *right;    ///< Expression on the right side of assignment
 };
 
@@ -327,10 +406,6 @@ class binary_expr_t : public expression_t {
 public:
   binary_expr_t(expression_t *left, token_e op, expression_t *right)
       : left(left), op(op), right(right) {}
-  ~binary_expr_t() {
-    delete left;
-    delete right;
-  }
   virtual std::string to_prefix_notation() const;
   virtual std::string debug_print() const;
   virtual void accept_visitor(visitor_t *visitor) {
@@ -352,7 +427,6 @@ public:
 class unary_expr_t : public expression_t {
 public:
   unary_expr_t(token_e op, expression_t *operand) : op(op), operand(operand) {}
-  ~unary_expr_t() { delete operand; }
   virtual std::string to_prefix_notation() const;
   virtual std::string debug_print() const;
   virtual void accept_visitor(visitor_t *visitor) {
@@ -364,8 +438,10 @@ public:
   expression_t *operand; ///< Operand expression
 };
 
-/// @brief Type alias for literal values that can be stored in the AST
-using literal_t = std::variant<int, float, double, char, char *, std::string>;
+/// @brief Type alias for literal values that can be stored in the AST,
+/// identifiers are stored as their symbol and strings in the tree's arena
+using literal_t = std::variant<int, float, double, char, char *,
+                               std::string_view, symbol_id_t>;
 
 /**
  * @class literal_expr_t
@@ -376,7 +452,6 @@ using literal_t = std::variant<int, float, double, char, char *, std::string>;
 class literal_expr_t : public expression_t {
 public:
   literal_expr_t(token_e type, literal_t value) : type(type), value(value) {}
-  ~literal_expr_t() = default;
   virtual std::string to_prefix_notation() const;
   virtual std::string debug_print() const;
   virtual void accept_visitor(visitor_t *visitor) {
@@ -396,14 +471,9 @@ public:
  */
 class call_expr_t : public expression_t {
 public:
-  call_expr_t(std::string function_name, std::vector<expression_t *> arguments)
+  call_expr_t(symbol_id_t function_name,
+              node_list_t<expression_t *> arguments)
       : function_name(function_name), arguments(arguments) {}
-
-  ~call_expr_t() {
-    for (auto arg : arguments) {
-      delete arg;
-    }
-  }
   virtual std::string to_prefix_notation() const;
   virtual std::string debug_print() const;
   virtual void accept_visitor(visitor_t *visitor) {
@@ -411,8 +481,8 @@ public:
   }
 
 public:
-  std::string function_name;             ///< Name of the function being called
-  std::vector<expression_t *> arguments; ///< List of argument expressions
+  symbol_id_t function_name;             ///< Name of the function being called
+  node_list_t<expression_t *> arguments; ///< List of argument expressions
 };
 
 /**
@@ -425,11 +495,6 @@ class subscript_expr_t : public expression_t {
 public:
   subscript_expr_t(expression_t *array, expression_t *index)
       : array(array), index(index) {}
-
-  ~subscript_expr_t() {
-    delete array;
-    delete index;
-  }
   virtual std::string to_prefix_notation() const;
   virtual std::string debug_print() const;
   virtual void accept_visitor(visitor_t *visitor) {
@@ -447,17 +512,28 @@ public:
  * @class abstract_syntax_tree_t
  * @brief Container for a complete abstract syntax tree
  *
- * Represents a parsed program or program fragment with a root node.
+ * Represents a parsed program or program fragment with a root node. Every
+ * node of the tree is placed in its arena with arena_t::create(), so nodes
+ * are never deleted one by one; the whole tree goes away with the arena.
  */
 class abstract_syntax_tree_t {
 public:
+  abstract_syntax_tree_t();
+  ~abstract_syntax_tree_t();
+
   /**
    * @brief Generates a debug string representation of the entire AST
    * @return String containing the tree structure and node information
    */
   std::string debug_print();
 
-  node::node_t *p_head; ///< Root node of the abstract syntax tree
+  node::node_t *p_head = nullptr; ///< Root node of the abstract syntax tree
+  arena_t arena;                  ///< Owns every node of the tree
+
+  /// Global scope, kept while a deferred function body may still be parsed
+  std::shared_ptr<symbol_table::symbol_table_t> p_globals;
+  /// Scope of the parameters of a deferred function body
+  std::unique_ptr<symbol_table::symbol_table_t> p_scope;
 };
 
 } // namespace ast
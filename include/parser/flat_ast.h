@@ -0,0 +1,156 @@
+/**
+ * @file flat_ast.h
+ * @brief Structure-of-arrays storage for abstract syntax trees
+ */
+
+#ifndef FLAT_AST_H
+#define FLAT_AST_H
+
+#include "interner.h"
+#include "parser/abstract_syntax_tree.h"
+#include "tokens.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace compiler {
+namespace parser {
+
+/// @brief Position of a node inside a flat_ast_t
+using node_id_t = uint32_t;
+
+/// @brief Marks a missing child, e.g. a variable without initializer
+constexpr node_id_t no_node = UINT32_MAX;
+
+/**
+ * @enum flat_node_e
+ * @brief Kind of a node in a flat_ast_t, one per ast::node class
+ */
+enum flat_node_e : uint8_t {
+  node_function,
+  node_variable,
+  node_block,
+  node_if,
+  node_else,
+  node_for,
+  node_while,
+  node_do,
+  node_return,
+  node_assign,
+  node_binary,
+  node_unary,
+  node_call,
+  node_subscript,
+  node_literal,
+};
+
+/**
+ * @class flat_ast_t
+ * @brief Compact copy of abstract syntax trees, addressed by node_id_t
+ *
+ * Instead of one object per node with a vtable and 64-bit child pointers,
+ * every node field lives in its own array: kind and tag as one byte each,
+ * two children and a value as 32-bit entries. Nodes with more than two
+ * children keep them in a shared array of extra words. By kind:
+ *
+ * - function: tag return type, lhs block, value name, rhs index of the extra
+ *   words pointer level, n, then type and pointer level of n parameters
+ * - variable: tag type, lhs initializer or no_node, rhs pointer level,
+ *   value name
+ * - block, call: lhs index of the extra words holding the statement or
+ *   argument ids, rhs their count; a call's value is the function
+ * - if, while, do: lhs condition, rhs statement; else: lhs statement
+ * - for: lhs index of the extra words first, condition, last, block
+ * - return: lhs expression; assign: lhs expression, value variable
+ * - binary, unary: tag operator, lhs and rhs operands
+ * - subscript: lhs array, rhs index
+ * - literal: tag token kind, value the token_value_t, for tok_string the
+ *   index into strings()
+ *
+ * Nodes are stored in post-order, a node's children always have smaller ids.
+ * A single pass from the first to the last id therefore sees every operand
+ * before the node using it.
+ */
+class flat_ast_t {
+public:
+  flat_ast_t() = default;
+
+  /**
+   * @brief Appends a copy of a tree
+   * @param tree The tree, it is not referenced afterwards
+   * @return Id of the tree's root, no_node for an empty tree
+   */
+  node_id_t append(const ast::abstract_syntax_tree_t &tree);
+
+  /**
+   * @brief Appends a copy of a subtree
+   * @param p_node Root of the subtree, may be nullptr
+   * @return Id of the copied root, no_node if p_node is nullptr
+   */
+  node_id_t append(ast::node::node_t *p_node);
+
+  node_id_t size() const { return static_cast<node_id_t>(_kinds.size()); }
+  bool empty() const { return _kinds.empty(); }
+
+  flat_node_e kind(node_id_t id) const {
+    return static_cast<flat_node_e>(_kinds[id]);
+  }
+  token_e tag(node_id_t id) const { return static_cast<token_e>(_tags[id]); }
+  node_id_t lhs(node_id_t id) const { return _lhs[id]; }
+  node_id_t rhs(node_id_t id) const { return _rhs[id]; }
+  token_value_t value(node_id_t id) const { return _values[id]; }
+
+  /**
+   * @brief Gets the extra words of a node, see the class description
+   * @param index Index stored in the node's lhs or rhs
+   * @return Pointer to the first word
+   */
+  const uint32_t *extra(uint32_t index) const { return _extra.data() + index; }
+
+  /**
+   * @brief Gets the ids of the roots appended so far, in order
+   * @return The roots
+   */
+  const std::vector<node_id_t> &roots() const { return _roots; }
+
+  /**
+   * @brief Gets the contents of the string literals
+   * @return The strings, indexed by the value of a tok_string literal
+   */
+  const std::vector<std::string> &strings() const { return _strings; }
+
+  /**
+   * @brief Converts an expression to prefix notation
+   * @param id Expression node
+   * @return The same string ast::node::expression_t::to_prefix_notation gives
+   */
+  std::string to_prefix_notation(node_id_t id) const;
+
+  /**
+   * @brief Gets the memory held by the node arrays
+   * @return Bytes in use, without unused capacity and string contents
+   */
+  size_t memory_usage() const;
+
+private:
+  friend class flatten_visitor_t;
+
+  node_id_t push_back(flat_node_e kind, token_e tag, node_id_t lhs,
+                      node_id_t rhs, token_value_t value = {no_symbol});
+
+  std::vector<uint8_t> _kinds;
+  std::vector<uint8_t> _tags;
+  std::vector<node_id_t> _lhs;
+  std::vector<node_id_t> _rhs;
+  std::vector<token_value_t> _values;
+  std::vector<uint32_t> _extra;
+  std::vector<std::string> _strings;
+  std::vector<node_id_t> _roots;
+};
+
+} // namespace parser
+} // namespace compiler
+
+#endif /* end of include guard: FLAT_AST_H */
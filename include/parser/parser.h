@@ -9,8 +9,13 @@
 #ifndef PARSER_H
 #define PARSER_H
 
+#include "diagnostics.h"
+#include "lexer/lexer.h"
 #include "parser/abstract_syntax_tree.h"
+#include "thread_pool.h"
+#include "token_buffer.h"
 #include "tokens.h"
+#include <cstddef>
 #include <vector>
 
 namespace compiler {
@@ -25,15 +30,85 @@ namespace parser {
 class parser_t {};
 
 /**
- * @brief Parses a vector of tokens into abstract syntax trees
- * @param tokens Vector of token pointers to parse
+ * @brief Parses a token stream into abstract syntax trees
+ * @param tokens The tokens to parse
+ * @param p_diagnostics Collects every syntax error, may be nullptr
  * @return Vector of AST pointers representing the parsed program
+ * @throws exceptions::syntax_error at the first error if p_diagnostics is
+ * nullptr
+ *
+ * With diagnostics the parser recovers from an error and keeps going: an
+ * error in a block skips to after the next ; or to the }, any other error
+ * to the next top level type followed by an identifier. Definitions with an
+ * error at the top level are left out of the result.
  *
  * Processes the token stream and constructs ASTs for all top-level
- * declarations and definitions in the source code.
+ * declarations and definitions in the source code. Streams of
+ * parallel_parse_threshold tokens or more are parsed with parse_parallel on
+ * the shared thread pool.
+ */
+std::vector<ast::abstract_syntax_tree_t *> *
+parse_tokens(const token_buffer_t &tokens,
+             diagnostics_t *p_diagnostics = nullptr);
+
+/// @brief Token streams at least this long are parsed by parse_tokens in
+/// parallel
+constexpr size_t parallel_parse_threshold = 64 * 1024;
+
+/**
+ * @brief Parses a token stream, the function bodies on several threads
+ * @param tokens The tokens to parse
+ * @param pool Threads to parse on
+ * @param p_diagnostics Collects every syntax error, may be nullptr
+ * @return Exactly the trees parse_tokens would return, in source order
+ *
+ * A scan matching braces splits the stream into its top level definitions.
+ * Global variables and function signatures are parsed in order, then the
+ * bodies concurrently, each into the arena of its own tree. A body only sees
+ * the definitions above it, as when parsing sequentially. Streams that do
+ * not split cleanly, or that fail to parse, are parsed again sequentially
+ * so errors are reported the same way.
+ */
+std::vector<ast::abstract_syntax_tree_t *> *
+parse_parallel(const token_buffer_t &tokens, thread_pool_t &pool,
+               diagnostics_t *p_diagnostics = nullptr);
+
+/**
+ * @brief Parses a token stream, deferring the function bodies
+ * @param tokens The tokens to parse, must outlive the returned trees
+ * @return Trees of all top level definitions, in source order
+ *
+ * Global variables and function signatures are parsed as by parse_tokens.
+ * Each function body is only recorded by its token range and parsed when
+ * ast::node::function_t::body() is first called, so outlines and signature
+ * queries cost time in the number of definitions rather than the code size.
+ * Errors in a body are thrown by body(). Streams whose top level does not
+ * split cleanly are parsed completely, as by parse_tokens.
+ */
+std::vector<ast::abstract_syntax_tree_t *> *
+parse_declarations(const token_buffer_t &tokens);
+
+/**
+ * @brief Parses the deferred body of a function
+ * @param p_func Function from parse_declarations, its body still deferred
+ * @throws exceptions::syntax_error if the body does not parse
+ *
+ * Called by ast::node::function_t::body(), which should be used instead.
+ */
+void parse_deferred_body(const ast::node::function_t *p_func);
+
+/**
+ * @brief Parses the tokens of a streaming lexer as they are produced
+ * @param lexer Lexer positioned at the start of its source
+ * @param p_diagnostics Collects every syntax error, may be nullptr
+ * @return Vector of AST pointers representing the parsed program
+ *
+ * Tokens are pulled on demand and dropped once consumed, so no token stream
+ * for the whole source is ever materialized. Errors are handled as by
+ * parse_tokens.
  */
 std::vector<ast::abstract_syntax_tree_t *> *
-parse_tokens(std::vector<token_t *> &tokens);
+parse_stream(lexer::lexer_t &lexer, diagnostics_t *p_diagnostics = nullptr);
 
 } // namespace parser
 
@@ -10,12 +10,15 @@
 #ifndef PRATT_PARSER_H
 #define PRATT_PARSER_H
 
+#include "arena.h"
 #include "parser/abstract_syntax_tree.h"
 #include "parser/expression.h"
+#include "parser/token_cursor.h"
 #include "symbol_table.h"
 #include "tokens.h"
 #include <map>
 #include <tuple>
+#include <vector>
 
 namespace compiler {
 namespace parser {
@@ -42,11 +45,11 @@ enum class ParseContext {
 bool is_unary_context(ParseContext context);
 
 /**
- * @brief Gets the precedence level for an operator token
- * @param tok The operator token
- * @return Precedence level (higher values bind more tightly)
+ * @brief Gets how tightly an infix operator binds its left operand
+ * @param tok The token following an operand
+ * @return token_spec's left binding power, 0 if tok is no infix operator
  */
-int get_presidence(token_e tok);
+int get_left_binding_power(token_e tok);
 
 /**
  * @brief Checks if a token marks the end of an expression
@@ -57,20 +60,24 @@ bool is_expression_delimiter(token_e tok);
 
 /**
  * @brief Parses an expression from a token stream
- * @param tokens Vector of tokens to parse (consumed from back)
+ * @param tokens Cursor positioned at the first token of the expression
  * @param p_symbol_table Symbol table for variable/function lookup
- * @param last_op_precedence Precedence of the previous operator (for recursion)
+ * @param p_arena Arena of the tree, the nodes are created in it
+ * @param min_binding_power Only operators binding tighter are parsed
  * @param context Current parsing context (for unary operator detection)
  * @return Pointer to the parsed expression AST node
  *
- * Uses the Pratt parsing algorithm to parse expressions with correct
- * operator precedence and associativity. The token vector is consumed
- * from the back, treating it as a stack.
+ * Uses the Pratt parsing algorithm, driven by the binding powers in
+ * token_spec. Every token is looked at once, so the time is linear in the
+ * length of the expression. Open parentheses, calls and operators waiting
+ * for their right operand are kept on an explicit stack rather than the call
+ * stack, so arbitrarily deep nesting cannot overflow it. A delimiter ending
+ * the expression (;, ), ...) is consumed as well.
  */
 ast::node::expression_t *
-parse_expression(std::vector<token_t *> &tokens,
-                 symbol_table::symbol_table_t *p_symbol_table,
-                 int last_op_precedence = 0,
+parse_expression(token_cursor_t &tokens,
+                 symbol_table::symbol_table_t *p_symbol_table, arena_t *p_arena,
+                 int min_binding_power = 0,
                  ParseContext context = ParseContext::START);
 
 } // namespace pratt_parser
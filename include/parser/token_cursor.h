@@ -0,0 +1,202 @@
+/**
+ * @file token_cursor.h
+ * @brief Read position of the parser in a token stream
+ */
+
+#ifndef TOKEN_CURSOR_H
+#define TOKEN_CURSOR_H
+
+#include "arena.h"
+#include "lexer/lexer.h"
+#include "token_buffer.h"
+#include "tokens.h"
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace compiler {
+namespace parser {
+
+/**
+ * @struct token_checkpoint_t
+ * @brief Read position saved by token_cursor_t::checkpoint()
+ */
+struct token_checkpoint_t {
+  size_t position;
+};
+
+/**
+ * @class token_cursor_t
+ * @brief Hands tokens to the parser one at a time
+ *
+ * The cursor either walks a token_buffer_t that was lexed up front, or pulls
+ * tokens on demand from a streaming lexer_t. In the streaming case only the
+ * lexer's lookahead ring is held in memory, so lookahead is limited to
+ * lexer_t::max_lookahead tokens. Past the end every peek returns tok_eof.
+ *
+ * A checkpoint() lets the parser try a production and rewind() if it does
+ * not match. Over a buffer that only saves the position. A streaming cursor
+ * records the tokens consumed while a checkpoint is held and replays them
+ * after a rewind, so the lexer never has to go back.
+ */
+class token_cursor_t {
+public:
+  /**
+   * @brief Creates a cursor over already lexed tokens
+   * @param tokens The tokens, must outlive the cursor and end with tok_eof
+   * @param position Index of the first token to read, counts as consumed
+   */
+  explicit token_cursor_t(const token_buffer_t &tokens, size_t position = 0)
+      : _p_buffer(&tokens), _p_lexer(nullptr), _position(position),
+        _history_start(position), _n_checkpoints(0) {}
+
+  /**
+   * @brief Creates a cursor that lexes while the parser consumes
+   * @param lexer The streaming lexer, must outlive the cursor
+   */
+  explicit token_cursor_t(lexer::lexer_t &lexer)
+      : _p_buffer(nullptr), _p_lexer(&lexer), _position(0),
+        _history_start(0), _n_checkpoints(0) {}
+
+  /**
+   * @brief Gets the kind of an upcoming token
+   * @param k Number of tokens to skip, 0 is the current token
+   * @return The token kind
+   */
+  token_e peek_kind(size_t k = 0) {
+    if (this->_p_lexer != nullptr) {
+      return this->stream_peek(k).e_tok_type;
+    }
+    return this->_p_buffer->kind(this->buffer_index(k));
+  }
+
+  /**
+   * @brief Gets an upcoming token
+   * @param k Number of tokens to skip, 0 is the current token
+   * @return The token
+   */
+  token_t peek(size_t k = 0) {
+    if (this->_p_lexer != nullptr) {
+      return this->stream_peek(k);
+    }
+    return this->_p_buffer->get(this->buffer_index(k));
+  }
+
+  /**
+   * @brief Consumes the current token
+   * @return The consumed token
+   */
+  token_t advance() {
+    this->_position++;
+    if (this->_p_lexer != nullptr) {
+      return this->stream_advance();
+    }
+    return this->_p_buffer->get(this->buffer_index(0, 1));
+  }
+
+  /**
+   * @brief Gets the number of tokens consumed so far
+   * @return Count of advance() calls, minus the ones undone by rewind()
+   */
+  size_t position() const { return this->_position; }
+
+  /**
+   * @brief Saves the read position to return to it later
+   * @return The position, pass it to rewind() or commit() exactly once
+   *
+   * Checkpoints nest; they have to be released in reverse order.
+   */
+  token_checkpoint_t checkpoint() {
+    if (this->_history.empty()) {
+      this->_history_start = this->_position;
+    }
+    this->_n_checkpoints++;
+    return token_checkpoint_t{this->_position};
+  }
+
+  /**
+   * @brief Returns to a checkpoint and releases it
+   * @param checkpoint A checkpoint that was not released yet
+   */
+  void rewind(token_checkpoint_t checkpoint) {
+    assert(this->_n_checkpoints > 0 && checkpoint.position <= this->_position);
+    this->_position = checkpoint.position;
+    this->release();
+  }
+
+  /**
+   * @brief Keeps the current position and releases a checkpoint
+   * @param checkpoint A checkpoint that was not released yet
+   */
+  void commit(token_checkpoint_t checkpoint) {
+    assert(this->_n_checkpoints > 0 && checkpoint.position <= this->_position);
+    (void)checkpoint;
+    this->release();
+  }
+
+private:
+  token_index_t buffer_index(size_t k, size_t consumed = 0) const {
+    size_t i = this->_position - consumed + k;
+    size_t last = this->_p_buffer->size() - 1;
+    return static_cast<token_index_t>(i < last ? i : last);
+  }
+
+  size_t history_end() const {
+    return this->_history_start + this->_history.size();
+  }
+
+  const token_t &stream_peek(size_t k) {
+    size_t i = this->_position + k;
+    if (i < this->history_end()) {
+      return this->_history[i - this->_history_start];
+    }
+    return this->_p_lexer->peek(i - this->history_end());
+  }
+
+  token_t stream_advance() {
+    size_t i = this->_position - 1;
+    if (i < this->history_end()) {
+      // the lexeme is in _lexemes, trimmed once the lexer is read again
+      return this->_history[i - this->_history_start];
+    }
+
+    this->trim_history();
+    token_t tok = this->_p_lexer->next_token();
+    if (this->_n_checkpoints > 0) {
+      // the lexer may drop the lexeme once it reads on, keep a copy
+      tok.t_val = this->_lexemes.copy(tok.t_val);
+      this->_history.push_back(tok);
+    } else {
+      this->_history_start = this->_position;
+    }
+    return tok;
+  }
+
+  void release() { this->_n_checkpoints--; }
+
+  /// drops the recorded tokens once nothing can rewind to them, as the
+  /// lexer does, a lexeme stays valid until the next token is lexed
+  void trim_history() {
+    if (this->_n_checkpoints == 0 && this->_position >= this->history_end() &&
+        !this->_history.empty()) {
+      this->_history.clear();
+      this->_history_start = this->_position;
+      this->_lexemes.release();
+    }
+  }
+
+  const token_buffer_t *_p_buffer;
+  lexer::lexer_t *_p_lexer;
+  size_t _position;
+
+  // tokens a streaming cursor consumed while a checkpoint was held
+  std::vector<token_t> _history;
+  size_t _history_start; ///< position of _history[0]
+  size_t _n_checkpoints;
+  arena_t _lexemes;
+};
+
+} // namespace parser
+} // namespace compiler
+
+#endif /* end of include guard: TOKEN_CURSOR_H */
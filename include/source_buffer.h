@@ -0,0 +1,83 @@
+/**
+ * @file source_buffer.h
+ * @brief Read-only storage for the source code of one compilation
+ */
+
+#ifndef SOURCE_BUFFER_H
+#define SOURCE_BUFFER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace compiler {
+
+/**
+ * @class source_buffer_t
+ * @brief Owns the bytes of a source file for the whole compile
+ *
+ * Regular files are memory-mapped, everything else (pipes, character devices)
+ * is read into memory. Tokens keep std::string_view's into the buffer, so the
+ * buffer has to outlive every token lexed from it.
+ */
+class source_buffer_t {
+public:
+  /**
+   * @brief Creates an empty buffer
+   */
+  source_buffer_t();
+
+  /**
+   * @brief Maps or reads the file at the given path
+   * @param t_path Path of the source file
+   * @throws std::runtime_error if the file cannot be opened or read
+   */
+  explicit source_buffer_t(const std::string &t_path);
+
+  source_buffer_t(const source_buffer_t &) = delete;
+  source_buffer_t &operator=(const source_buffer_t &) = delete;
+  source_buffer_t(source_buffer_t &&other) noexcept;
+  source_buffer_t &operator=(source_buffer_t &&other) noexcept;
+  ~source_buffer_t();
+
+  /**
+   * @brief Creates a buffer that owns a copy of in-memory source code
+   * @param t_source The source code
+   * @return The buffer holding the source
+   */
+  static source_buffer_t from_string(std::string t_source);
+
+  /**
+   * @brief Gets the source code
+   * @return View of the complete buffer
+   */
+  std::string_view view() const { return std::string_view(_p_data, _size); }
+
+  const char *data() const { return _p_data; }
+  size_t size() const { return _size; }
+
+  /**
+   * @brief Gets the path the buffer was loaded from
+   * @return The path, empty for in-memory sources
+   */
+  const std::string &path() const { return _t_path; }
+
+  /**
+   * @brief Checks whether the buffer is backed by a memory mapping
+   * @return True if the file was mapped, false if it was read
+   */
+  bool is_mapped() const { return _p_mapping != nullptr; }
+
+private:
+  void release();
+
+  std::string _t_path;
+  std::string _t_owned; ///< storage when the input could not be mapped
+  const char *_p_data;
+  size_t _size;
+  void *_p_mapping;
+};
+
+} // namespace compiler
+
+#endif /* end of include guard: SOURCE_BUFFER_H */
@@ -0,0 +1,62 @@
+/**
+ * @file source_stream.h
+ * @brief Chunked reading of source code that is still being written
+ */
+
+#ifndef SOURCE_STREAM_H
+#define SOURCE_STREAM_H
+
+#include <cstddef>
+#include <string>
+
+namespace compiler {
+
+/**
+ * @class source_stream_t
+ * @brief Reads source code from a file descriptor a chunk at a time
+ *
+ * Unlike source_buffer_t the input never has to be complete: every chunk is
+ * handed on as soon as the writer produced it, so a pipe or stdin can be
+ * compiled while the program generating it is still running. See
+ * lexer::lexer_t for the rolling buffer the chunks are lexed in.
+ */
+class source_stream_t {
+public:
+  /// @brief Bytes requested from the descriptor per read
+  static constexpr size_t default_chunk_size = 64 * 1024;
+
+  /**
+   * @brief Reads from an open file descriptor
+   * @param fd The descriptor, stays owned by the caller
+   * @param chunk_size Bytes to request per read
+   */
+  explicit source_stream_t(int fd, size_t chunk_size = default_chunk_size);
+
+  source_stream_t(const source_stream_t &) = delete;
+  source_stream_t &operator=(const source_stream_t &) = delete;
+
+  /**
+   * @brief Appends the next chunk of input
+   * @param p_buffer String to append to
+   * @return Number of bytes appended, 0 once the input has ended
+   * @throws std::runtime_error if reading fails
+   *
+   * Blocks until the writer produced some bytes or closed its end.
+   */
+  size_t read_chunk(std::string *p_buffer);
+
+  /**
+   * @brief Checks whether the input has ended
+   * @return true once read_chunk() saw the end of input
+   */
+  bool at_end() const { return _at_end; }
+
+private:
+  int _fd;
+  size_t _chunk_size;
+  bool _at_end;
+};
+
+} // namespace compiler
+
+#endif /* end of include guard: SOURCE_STREAM_H */
@@ -1,11 +1,14 @@
 #ifndef SYMBOL_TABLE_H
 #define SYMBOL_TABLE_H
 
+#include "interner.h"
 #include "parser/abstract_syntax_tree.h"
 #include "tokens.h"
-#include <map>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <tuple>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
@@ -36,6 +39,8 @@ public:
   bool is_const;
   bool is_static;
   bool is_function;
+  // position of the top level definition that declared the symbol
+  size_t declaration_index = 0;
 
 private:
   parser::ast::node::expression_t *p_expr;
@@ -45,14 +50,17 @@ class symbol_table_t {
 public:
   symbol_table_t();
   symbol_table_t(symbol_table_t *p_previous);
-  bool is_defined(std::string id);
+  bool is_defined(symbol_id_t id);
   void add(parser::ast::node::node_t *p_node);
   void assign(parser::ast::node::assign_expr_t *p_assign);
-  data_t *get(std::string id) { return this->table.find(id)->second; }
+  data_t *get(symbol_id_t id) { return this->table.find(id)->second; }
 
 public:
   symbol_table_t *p_previous;
-  std::map<std::string, data_t *> table;
+  std::unordered_map<symbol_id_t, data_t *> table;
+  // lookups through this table ignore symbols with a larger
+  // declaration_index, see parser::parse_parallel
+  size_t max_declaration_index = SIZE_MAX;
 };
 
 } // namespace compiler::symbol_table
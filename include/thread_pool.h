@@ -0,0 +1,77 @@
+/**
+ * @file thread_pool.h
+ * @brief Fixed set of worker threads for data parallel compiler passes
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace compiler {
+
+/**
+ * @class thread_pool_t
+ * @brief Runs independent tasks on a fixed number of threads
+ *
+ * The thread calling parallel_for() works on the tasks as well, so a pool of
+ * size n starts n - 1 workers and a pool of size 1 runs everything inline.
+ */
+class thread_pool_t {
+public:
+  /**
+   * @brief Starts the workers
+   * @param n_threads Total number of threads including the caller, 0 picks
+   *                  the number of hardware threads
+   */
+  explicit thread_pool_t(size_t n_threads = 0);
+
+  thread_pool_t(const thread_pool_t &) = delete;
+  thread_pool_t &operator=(const thread_pool_t &) = delete;
+
+  /**
+   * @brief Finishes queued tasks and joins the workers
+   */
+  ~thread_pool_t();
+
+  /**
+   * @brief Gets the number of threads working on tasks
+   * @return Workers plus the calling thread
+   */
+  size_t size() const { return _workers.size() + 1; }
+
+  /**
+   * @brief Runs task(0) ... task(n - 1) and waits for all of them
+   * @param n Number of tasks
+   * @param task Called once per task index, possibly concurrently
+   * @throws The first exception thrown by a task, after all tasks ended
+   */
+  void parallel_for(size_t n, const std::function<void(size_t)> &task);
+
+  /**
+   * @brief Gets the pool shared by the whole compiler
+   * @return Pool sized to the hardware, created on first use
+   */
+  static thread_pool_t &shared();
+
+private:
+  void work();
+  bool run_one(std::unique_lock<std::mutex> &lock);
+
+  std::vector<std::thread> _workers;
+  std::deque<std::function<void()>> _queue;
+  std::mutex _mutex;
+  std::condition_variable _task_ready;
+  std::condition_variable _task_done;
+  bool _stopping;
+};
+
+} // namespace compiler
+
+#endif /* end of include guard: THREAD_POOL_H */
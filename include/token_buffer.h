@@ -0,0 +1,220 @@
+/**
+ * @file token_buffer.h
+ * @brief Structure-of-arrays storage for the tokens of one source
+ */
+
+#ifndef TOKEN_BUFFER_H
+#define TOKEN_BUFFER_H
+
+#include "interner.h"
+#include "tokens.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace compiler {
+
+/// @brief Position of a token inside a token_buffer_t
+using token_index_t = uint32_t;
+
+/**
+ * @class token_buffer_t
+ * @brief Dense token stream produced by the lexer
+ *
+ * Instead of one heap object per token, every token field lives in its own
+ * array: kinds as one byte each, offset and length of the lexeme in the
+ * source and the decoded token_value_t as 32-bit values. Tokens are addressed
+ * by a token_index_t. Lexemes are not stored, they are sliced out of the
+ * source on demand, so the source must outlive the buffer.
+ */
+class token_buffer_t {
+public:
+  token_buffer_t() = default;
+
+  /**
+   * @brief Creates an empty buffer for tokens of the given source
+   * @param t_source The source the token offsets refer to
+   */
+  explicit token_buffer_t(std::string_view t_source) : _t_source(t_source) {}
+
+  /**
+   * @brief Appends a token
+   * @param kind Token type
+   * @param offset Byte offset of the lexeme in the source
+   * @param length Length of the lexeme in bytes
+   * @param value Decoded lexeme, see token_value_t
+   * @return Index of the new token
+   */
+  token_index_t push_back(token_e kind, uint32_t offset, uint32_t length,
+                          token_value_t value = token_value_t{no_symbol}) {
+    _kinds.push_back(static_cast<uint8_t>(kind));
+    _offsets.push_back(offset);
+    _lengths.push_back(length);
+    _values.push_back(value);
+    return static_cast<token_index_t>(_kinds.size() - 1);
+  }
+
+  /**
+   * @brief Appends the leading tokens of another buffer
+   * @param other Buffer over the same source
+   * @param count Number of tokens to copy from the front of other
+   */
+  void append(const token_buffer_t &other, token_index_t count) {
+    _kinds.insert(_kinds.end(), other._kinds.begin(),
+                  other._kinds.begin() + count);
+    _offsets.insert(_offsets.end(), other._offsets.begin(),
+                    other._offsets.begin() + count);
+    _lengths.insert(_lengths.end(), other._lengths.begin(),
+                    other._lengths.begin() + count);
+    _values.insert(_values.end(), other._values.begin(),
+                   other._values.begin() + count);
+  }
+
+  /**
+   * @brief Replaces a range of tokens after the source was edited
+   * @param t_source The edited source
+   * @param first Index of the first replaced token
+   * @param count Number of replaced tokens
+   * @param replacement Tokens to insert, their offsets refer to t_source
+   * @param offset_delta Added to the offset of every token after the range
+   */
+  void splice(std::string_view t_source, token_index_t first,
+              token_index_t count, const token_buffer_t &replacement,
+              int64_t offset_delta) {
+    _t_source = t_source;
+    splice_array(_kinds, first, count, replacement._kinds);
+    splice_array(_offsets, first, count, replacement._offsets);
+    splice_array(_lengths, first, count, replacement._lengths);
+    splice_array(_values, first, count, replacement._values);
+
+    // the tail only moves, a linear pass the compiler vectorizes
+    for (size_t i = first + replacement.size(); i < _offsets.size(); i++) {
+      _offsets[i] = static_cast<uint32_t>(_offsets[i] + offset_delta);
+    }
+  }
+
+  /**
+   * @brief Replaces all tokens by copies of raw arrays
+   * @param p_kinds Kinds, one byte per token
+   * @param p_offsets Offsets of the lexemes
+   * @param p_lengths Lengths of the lexemes
+   * @param p_values Decoded lexemes
+   * @param count Number of tokens in each array
+   */
+  void assign(const uint8_t *p_kinds, const uint32_t *p_offsets,
+              const uint32_t *p_lengths, const token_value_t *p_values,
+              token_index_t count) {
+    _kinds.assign(p_kinds, p_kinds + count);
+    _offsets.assign(p_offsets, p_offsets + count);
+    _lengths.assign(p_lengths, p_lengths + count);
+    _values.assign(p_values, p_values + count);
+  }
+
+  /**
+   * @brief Gets a token's value for updating it in place
+   * @param i Token index
+   * @return Reference to the decoded lexeme
+   */
+  token_value_t &value_at(token_index_t i) { return _values[i]; }
+
+  /**
+   * @brief Reserves space for a number of tokens
+   * @param n Number of tokens
+   */
+  void reserve(size_t n) {
+    _kinds.reserve(n);
+    _offsets.reserve(n);
+    _lengths.reserve(n);
+    _values.reserve(n);
+  }
+
+  token_index_t size() const {
+    return static_cast<token_index_t>(_kinds.size());
+  }
+  bool empty() const { return _kinds.empty(); }
+
+  token_e kind(token_index_t i) const {
+    return static_cast<token_e>(_kinds[i]);
+  }
+  uint32_t offset(token_index_t i) const { return _offsets[i]; }
+  uint32_t length(token_index_t i) const { return _lengths[i]; }
+  token_value_t value(token_index_t i) const { return _values[i]; }
+  symbol_id_t symbol(token_index_t i) const { return _values[i].symbol; }
+
+  /**
+   * @brief Gets the lexeme of a token
+   * @param i Token index
+   * @return View of the lexeme in the source
+   */
+  std::string_view text(token_index_t i) const {
+    return _t_source.substr(_offsets[i], _lengths[i]);
+  }
+
+  /**
+   * @brief Materializes a token for diagnostics and debug output
+   * @param i Token index
+   * @return Token referring to the same lexeme
+   */
+  token_t get(token_index_t i) const {
+    return token_t(kind(i), text(i), _offsets[i], _values[i]);
+  }
+
+  /**
+   * @brief Gets the source the tokens refer to
+   * @return View of the source
+   */
+  std::string_view source() const { return _t_source; }
+
+  /**
+   * @brief Gets the raw kind array, one byte per token
+   * @return Pointer to the first kind
+   */
+  const uint8_t *kinds() const { return _kinds.data(); }
+
+  /**
+   * @brief Gets the raw offset array, sorted in ascending order
+   * @return Pointer to the first offset
+   */
+  const uint32_t *offsets() const { return _offsets.data(); }
+
+  /**
+   * @brief Gets the raw length array
+   * @return Pointer to the first length
+   */
+  const uint32_t *lengths() const { return _lengths.data(); }
+
+  /**
+   * @brief Gets the raw value array
+   * @return Pointer to the first value
+   */
+  const token_value_t *values() const { return _values.data(); }
+
+private:
+  template <typename T>
+  static void splice_array(std::vector<T> &array, token_index_t first,
+                           token_index_t count,
+                           const std::vector<T> &replacement) {
+    size_t common = std::min<size_t>(count, replacement.size());
+    std::copy(replacement.begin(), replacement.begin() + common,
+              array.begin() + first);
+    if (count > common) {
+      array.erase(array.begin() + first + common,
+                  array.begin() + first + count);
+    } else {
+      array.insert(array.begin() + first + common,
+                   replacement.begin() + common, replacement.end());
+    }
+  }
+
+  std::string_view _t_source;
+  std::vector<uint8_t> _kinds;
+  std::vector<uint32_t> _offsets;
+  std::vector<uint32_t> _lengths;
+  std::vector<token_value_t> _values;
+};
+
+} // namespace compiler
+
+#endif /* end of include guard: TOKEN_BUFFER_H */
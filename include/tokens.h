@@ -1,13 +1,15 @@
 #ifndef TOKENS_H
 #define TOKENS_H
 
-#include <map>
-#include <regex>
+#include "arena.h"
+#include "interner.h"
+#include <cstddef>
+#include <cstdint>
 #include <string>
-#include <tuple>
+#include <string_view>
 
 namespace compiler {
-// order is inportant for regex matching
+// order is inportant, see token_spec
 enum token_e {
   // Special tokens
   tok_eof,
@@ -88,99 +90,31 @@ enum token_e {
   // Literals and identifiers
   tok_id,
   tok_number,
+  tok_float_literal,
   tok_string,
-  tok_char_literal
-};
-
-static std::map<token_e, std::regex> token_regex = {
-    {tok_eof, std::regex("(?!)")},
-    {tok_comment, std::regex("//[^\r\n]*")},
-
-    // Keywords - Type qualifiers (with word boundaries)
-    // {tok_let, std::regex("\\blet\\b")},
-    // {tok_mut, std::regex("\\bmut\\b")},
-    // {tok_dyn, std::regex("\\bdyn\\b")},
-    // {tok_static, std::regex("\\bstatic\\b")},
-    // {tok_typedef, std::regex("\\btypedef\\b")},
-
-    // Keywords - Primitive types
-    {tok_bool, std::regex("\\bbool\\b")},
-    {tok_char, std::regex("\\bchar\\b")},
-    // {tok_short, std::regex("\\bshort\\b")},
-    {tok_int, std::regex("\\bint\\b")},
-    // {tok_long_long,
-    //  std::regex("\\blong\\s+long\\b")}, // Must come before tok_long
-    // {tok_long, std::regex("\\blong\\b")},
-    {tok_float, std::regex("\\bfloat\\b")},
-    // {tok_double, std::regex("\\bdouble\\b")},
-    {tok_void, std::regex("\\bvoid\\b")},
-
-    // Keywords - Complex types
-    // {tok_enum, std::regex("\\benum\\b")},
-    // {tok_struct, std::regex("\\bstruct\\b")},
-    // {tok_union, std::regex("\\bunion\\b")},
-
-    // Keywords - Control flow
-    {tok_if, std::regex("\\bif\\b")},
-    {tok_else, std::regex("\\belse\\b")},
-    // {tok_switch, std::regex("\\bswitch\\b")},
-    // {tok_case, std::regex("\\bcase\\b")},
-    // {tok_default, std::regex("\\bdefault\\b")},
-    {tok_for, std::regex("\\bfor\\b")},
-    {tok_while, std::regex("\\bwhile\\b")},
-    // {tok_do, std::regex("\\bdo\\b")},
-    // {tok_break, std::regex("\\bbreak\\b")},
-    // {tok_continue, std::regex("\\bcontinue\\b")},
-    {tok_return, std::regex("\\breturn\\b")},
-
-    // Identifiers (must come after all keywords)
-    {tok_id, std::regex("[a-zA-Z_][a-zA-Z_0-9]*")},
-
-    // Literals
-    {tok_number, std::regex("\\d+\\.\\d+|\\.\\d+|\\d+")},
-    {tok_string, std::regex("\".*?\"")},
-    {tok_char_literal, std::regex("\'.\'")},
-
-    // Two-character operators (must come before single-character versions)
-    {tok_leq, std::regex("<=")},
-    {tok_geq, std::regex(">=")},
-    {tok_eq, std::regex("==")},
-    {tok_neq, std::regex("!=")},
-
-    // Operators - Arithmetic
-    {tok_plus, std::regex("\\+")},
-    {tok_minus, std::regex("\\-")},
-    {tok_star, std::regex("\\*")},
-    {tok_slash, std::regex("/")},
-    // {tok_percent, std::regex("%")},
-
-    // Operators - Assignment
-    {tok_assign, std::regex("=")},
-
-    // Operators - Comparison (single-character, after two-character)
-    {tok_lt, std::regex("<")},
-    {tok_gt, std::regex(">")},
-
-    // Operators - Logical
-    {tok_exclaimationmark, std::regex("!")},
-    // {tok_questionmark, std::regex("\\?")},
+  tok_char_literal,
 
-    // Delimiters - Parentheses and brackets
-    {tok_lparen, std::regex("\\(")},
-    {tok_rparen, std::regex("\\)")},
-    {tok_lbrace, std::regex("\\{")},
-    {tok_rbrace, std::regex("\\}")},
-    {tok_lbracket, std::regex("\\[")},
-    {tok_rbracket, std::regex("\\]")},
+  // Bytes no rule matches, see lexer_t
+  tok_error
+};
 
-    // Delimiters - Punctuation
-    {tok_comma, std::regex(",")},
-    {tok_semicolon, std::regex(";")},
-    {tok_colon, std::regex(":")},
-    // {tok_dot, std::regex("\\.")},
+/**
+ * @struct token_spec_t
+ * @brief One row of the token specification
+ */
+struct token_spec_t {
+  token_e kind;
+  std::string_view name;    ///< as printed by token_t::type_name()
+  std::string_view pattern; ///< ECMAScript regex of the lexemes
+  int left_precidence;      ///< binding power towards the left operand
+  int right_precidence;     ///< binding power towards the right operand
 };
 
-/** @brief definition of precidence levels
+/** @brief The token specification, one row per token_e in declaration order
+ *
+ * The lexer implements the patterns as a hand written DFA; they are kept here
+ * as the reference it is tested against. Where several patterns match the
+ * same length, the row declared first wins.
  *
  * @note Precedence hierarchy (C-style operator precedence):
  *
@@ -195,116 +129,168 @@ static std::map<token_e, std::regex> token_regex = {
  * 100: Atomic values (literals, identifiers)
  *
  * For right-associative operators (like = and ?:), rbp < lbp ensures
- * right-to-left grouping.*/
-static std::map<token_e, std::tuple<int, int>> token_presidence = {
-    {tok_eof, std::tuple<int, int>(0, 0)},
-    {tok_comment, std::tuple<int, int>(0, 0)},
-
-    // Keywords - Type qualifiers
-    // {tok_let, std::tuple<int, int>(0, 0)},
-    // {tok_mut, std::tuple<int, int>(0, 0)},
-    // {tok_dyn, std::tuple<int, int>(0, 0)},
-    // {tok_static, std::tuple<int, int>(0, 0)},
-    // {tok_typedef, std::tuple<int, int>(0, 0)},
+ * right-to-left grouping.
+ *
+ * The table is constexpr, so no code runs for it at startup. */
+inline constexpr token_spec_t token_spec[] = {
+    // Special tokens
+    {tok_eof, "eof", R"((?!))", 0, 0},
+    {tok_comment, "comment", R"(//[^\r\n]*)", 0, 0},
+
+    // Keywords - Type qualifiers (with word boundaries)
+    // {tok_let, "let", R"(\blet\b)", 0, 0},
+    // {tok_mut, "mut", R"(\bmut\b)", 0, 0},
+    // {tok_dyn, "dyn", R"(\bdyn\b)", 0, 0},
+    // {tok_static, "static", R"(\bstatic\b)", 0, 0},
+    // {tok_typedef, "typedef", R"(\btypedef\b)", 0, 0},
 
     // Keywords - Primitive types
-    {tok_bool, std::tuple<int, int>(0, 100)},
-    {tok_char, std::tuple<int, int>(0, 100)},
-    // {tok_short, std::tuple<int, int>(0, 100)},
-    {tok_int, std::tuple<int, int>(0, 100)},
-    // {tok_long_long, std::tuple<int, int>(0, 100)},
-    // {tok_long, std::tuple<int, int>(0, 100)},
-    {tok_float, std::tuple<int, int>(0, 100)},
-    // {tok_double, std::tuple<int, int>(0, 100)},
-    {tok_void, std::tuple<int, int>(0, 100)},
+    {tok_bool, "bool", R"(\bbool\b)", 0, 100},
+    {tok_char, "char", R"(\bchar\b)", 0, 100},
+    // {tok_short, "short", R"(\bshort\b)", 0, 100},
+    {tok_int, "int", R"(\bint\b)", 0, 100},
+    // {tok_long, "long", R"(\blong\b)", 0, 100},
+    // {tok_long_long, "longlong", R"(\blong\s+long\b)", 0, 100},
+    {tok_float, "float", R"(\bfloat\b)", 0, 100},
+    // {tok_double, "double", R"(\bdouble\b)", 0, 100},
+    {tok_void, "void", R"(\bvoid\b)", 0, 100},
 
     // Keywords - Complex types
-    // {tok_enum, std::tuple<int, int>(0, 100)},
-    // {tok_struct, std::tuple<int, int>(0, 100)},
-    // {tok_union, std::tuple<int, int>(0, 100)},
+    // {tok_enum, "enum", R"(\benum\b)", 0, 100},
+    // {tok_struct, "struct", R"(\bstruct\b)", 0, 100},
+    // {tok_union, "union", R"(\bunion\b)", 0, 100},
 
     // Keywords - Control flow
-    {tok_if, std::tuple<int, int>(0, 100)},
-    {tok_else, std::tuple<int, int>(0, 100)},
-    // {tok_switch, std::tuple<int, int>(0, 100)},
-    // {tok_case, std::tuple<int, int>(0, 100)},
-    // {tok_default, std::tuple<int, int>(0, 100)},
-    // {tok_for, std::tuple<int, int>(0, 100)},
-    {tok_while, std::tuple<int, int>(0, 100)},
-    // {tok_do, std::tuple<int, int>(0, 100)},
-    // {tok_break, std::tuple<int, int>(100, 0)},
-    // {tok_continue, std::tuple<int, int>(100, 0)},
-    {tok_return, std::tuple<int, int>(100, 100)},
-
-    // Identifiers
-    {tok_id, std::tuple<int, int>(0, 100)},
-
-    // Literals
-    {tok_number, std::tuple<int, int>(0, 100)},
-    {tok_string, std::tuple<int, int>(0, 100)},
-    {tok_char_literal, std::tuple<int, int>(0, 100)},
-
-    // Two-character operators
-    {tok_leq, std::tuple<int, int>(40, 41)},
-    {tok_geq, std::tuple<int, int>(40, 41)},
-    {tok_eq, std::tuple<int, int>(40, 41)},
-    {tok_neq, std::tuple<int, int>(40, 41)},
+    {tok_if, "if", R"(\bif\b)", 0, 100},
+    {tok_else, "else", R"(\belse\b)", 0, 100},
+    // {tok_switch, "switch", R"(\bswitch\b)", 0, 100},
+    // {tok_case, "case", R"(\bcase\b)", 0, 100},
+    // {tok_default, "default", R"(\bdefault\b)", 0, 100},
+    {tok_for, "for", R"(\bfor\b)", 0, 0},
+    {tok_while, "while", R"(\bwhile\b)", 0, 100},
+    // {tok_do, "do", R"(\bdo\b)", 0, 100},
+    // {tok_break, "break", R"(\bbreak\b)", 100, 0},
+    // {tok_continue, "continue", R"(\bcontinue\b)", 100, 0},
+    {tok_return, "return", R"(\breturn\b)", 100, 100},
 
     // Operators - Arithmetic
-    {tok_plus, std::tuple<int, int>(50, 51)},
-    {tok_minus, std::tuple<int, int>(50, 51)},
-    {tok_star, std::tuple<int, int>(55, 56)},
-    {tok_slash, std::tuple<int, int>(55, 56)},
-    // {tok_percent, std::tuple<int, int>(55, 56)},
+    {tok_plus, "plus", R"(\+)", 50, 51},
+    {tok_minus, "minus", R"(\-)", 50, 51},
+    {tok_star, "star", R"(\*)", 55, 56},
+    {tok_slash, "slash", R"(/)", 55, 56},
+    // {tok_percent, "percent", R"(%)", 55, 56},
 
     // Operators - Assignment (right-associative)
-    {tok_assign, std::tuple<int, int>(20, 19)},
+    {tok_assign, "assign", R"(=)", 20, 19},
 
     // Operators - Comparison
-    {tok_lt, std::tuple<int, int>(40, 41)},
-    {tok_gt, std::tuple<int, int>(40, 41)},
+    {tok_lt, "lt", R"(<)", 40, 41},
+    {tok_leq, "leq", R"(<=)", 40, 41},
+    {tok_gt, "gt", R"(>)", 40, 41},
+    {tok_geq, "geq", R"(>=)", 40, 41},
+    {tok_eq, "eq", R"(==)", 40, 41},
+    {tok_neq, "neq", R"(!=)", 40, 41},
 
     // Operators - Logical
-    {tok_exclaimationmark, std::tuple<int, int>(0, 60)}, // prefix unary
-    // {tok_questionmark, std::tuple<int, int>(15, 14)}, // ternary
-    // (right-assoc)
-
-    // Delimiters
-    {tok_lparen, std::tuple<int, int>(0, 100)},
-    {tok_rparen, std::tuple<int, int>(100, 0)},
-    {tok_lbrace, std::tuple<int, int>(0, 100)},
-    {tok_rbrace, std::tuple<int, int>(100, 0)},
-    {tok_lbracket, std::tuple<int, int>(70, 71)}, // array subscript
-    {tok_rbracket, std::tuple<int, int>(100, 0)},
+    {tok_exclaimationmark, "exclaimationmark", R"(!)", 0, 60}, // prefix unary
+    // {tok_questionmark, "questionmark", R"(\?)", 15, 14}, // ternary
+
+    // Delimiters - Parentheses and brackets
+    {tok_lparen, "lparen", R"(\()", 0, 100},
+    {tok_rparen, "rparen", R"(\))", 100, 0},
+    {tok_lbrace, "lbrace", R"(\{)", 0, 100},
+    {tok_rbrace, "rbrace", R"(\})", 100, 0},
+    {tok_lbracket, "lbracket", R"(\[)", 70, 71}, // array subscript
+    {tok_rbracket, "rbracket", R"(\])", 100, 0},
 
     // Delimiters - Punctuation
-    {tok_comma, std::tuple<int, int>(10, 11)},
-    {tok_semicolon, std::tuple<int, int>(0, 0)},
-    {tok_colon, std::tuple<int, int>(5, 6)},
-    // {tok_dot,
-    //  std::tuple<int, int>(80, 81)}, // member access (highest precedence)
+    {tok_comma, "comma", R"(,)", 10, 11},
+    {tok_semicolon, "semicolon", R"(;)", 0, 0},
+    {tok_colon, "colon", R"(:)", 5, 6},
+    // {tok_dot, "dot", R"(\.)", 80, 81}, // member access
+
+    // Literals and identifiers
+    {tok_id, "id", R"([a-zA-Z_][a-zA-Z_0-9]*)", 0, 100},
+    {tok_number, "number", R"(\d+)", 0, 100},
+    {tok_float_literal, "float_literal", R"(\d+\.\d+|\.\d+)", 0, 100},
+    {tok_string, "string", R"(".*?")", 0, 100},
+    {tok_char_literal, "char_literal", R"('.')", 0, 100},
+
+    // Run of bytes no other rule matches, never produced by its pattern
+    {tok_error, "error", R"((?!))", 0, 0},
 };
 
+/// @brief Number of token kinds
+constexpr size_t token_kind_count = sizeof(token_spec) / sizeof(token_spec[0]);
+
+constexpr bool token_spec_is_indexed_by_kind() {
+  for (size_t i = 0; i < token_kind_count; i++) {
+    if (static_cast<size_t>(token_spec[i].kind) != i) {
+      return false;
+    }
+  }
+  return true;
+}
+static_assert(token_kind_count == tok_error + 1 &&
+                  token_spec_is_indexed_by_kind(),
+              "token_spec needs one row per token_e, in declaration order");
+
 int get_left_precidence(token_e tok);
 
 int get_right_precidence(token_e tok);
 
+/**
+ * @union token_value_t
+ * @brief Payload the lexer decoded from a lexeme, the kind selects the member
+ */
+union token_value_t {
+  symbol_id_t symbol; ///< tok_id: interned lexeme, no_symbol for other kinds
+  int32_t integer;    ///< tok_number
+  float real;         ///< tok_float_literal
+};
+
+/**
+ * @class token_t
+ * @brief A lexical token
+ *
+ * The lexeme is a view into the source it was lexed from (usually a
+ * source_buffer_t), the token does not own the text. Only the byte offset of
+ * the lexeme is kept, a line_index_t turns it into a line and column when a
+ * diagnostic needs one. Identifiers carry their interned symbol and numeric
+ * literals their value, so later stages never look at the lexeme again.
+ */
 class token_t {
 public:
-  token_t(token_e e_tok_type, std::string tp_val, int linenumber);
+  token_t() : token_t(tok_eof, "", 0) {}
+  token_t(token_e e_tok_type, std::string_view tp_val, uint32_t offset,
+          token_value_t value = token_value_t{no_symbol});
   ~token_t() = default;
-  std::string type_name();
+  std::string type_name() const;
 
 public:
   token_e e_tok_type;
-  std::string t_val;
-  int linenumber;
+  std::string_view t_val;
+  uint32_t offset;     ///< byte offset of the lexeme in the source
+  token_value_t value; ///< decoded lexeme
 };
 
-token_t *create_token_t(token_e e_tok_type, std::string t_val, int linenumber);
+/**
+ * @brief Creates a token that lives as long as an arena
+ * @param arena Arena that owns the token and a copy of its lexeme
+ * @param e_tok_type Token type
+ * @param t_val Lexeme, copied into the arena
+ * @param offset Byte offset of the lexeme in the source
+ * @param value Decoded lexeme
+ * @return The token, freed with the arena
+ */
+token_t *create_token_t(arena_t &arena, token_e e_tok_type,
+                        std::string_view t_val, uint32_t offset,
+                        token_value_t value = token_value_t{no_symbol});
 
 std::string debug_tok(token_t *token);
 
+std::string debug_tok(const token_t &token);
+
 } // namespace compiler
 
 #endif /* end of include guard: TOKENS_H */
@@ -0,0 +1,40 @@
+#include "arena.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+namespace compiler {
+
+arena_t::arena_t(size_t block_size) {
+  this->_p_next = nullptr;
+  this->_p_end = nullptr;
+  this->_block_size = block_size;
+  this->_size = 0;
+}
+
+void *arena_t::allocate_slow(size_t size, size_t alignment) {
+  // oversized requests get a block of their own
+  size_t block_size = std::max(this->_block_size, size + alignment);
+  // not make_unique, which would zero the block
+  this->_blocks.push_back(std::unique_ptr<char[]>(new char[block_size]));
+  this->_p_next = this->_blocks.back().get();
+  this->_p_end = this->_p_next + block_size;
+  return this->allocate(size, alignment);
+}
+
+std::string_view arena_t::copy(std::string_view text) {
+  char *p = static_cast<char *>(this->allocate(text.length(), 1));
+  std::memcpy(p, text.data(), text.length());
+  return std::string_view(p, text.length());
+}
+
+void arena_t::release() {
+  this->_blocks.clear();
+  this->_p_next = nullptr;
+  this->_p_end = nullptr;
+  this->_size = 0;
+}
+
+} // namespace compiler
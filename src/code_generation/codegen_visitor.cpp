@@ -1,4 +1,5 @@
 #include "code_generation/codegen_visitor.h"
+#include "interner.h"
 #include "parser/abstract_syntax_tree.h"
 #include "tokens.h"
 #include <iostream>
@@ -68,25 +69,16 @@ void codegen_visitor_t::visit_literal_expr(literal_expr_t *t_literal_expr) {
   // Check if this is an identifier (variable reference)
   if (t_literal_expr->type == token_e::tok_id) {
     // This is a variable reference
-    std::string var_name = std::visit(
-        [](auto &&arg) -> std::string {
-          using T = std::decay_t<decltype(arg)>;
-          if constexpr (std::is_same_v<T, char *>) {
-            return std::string(arg);
-          } else if constexpr (std::is_same_v<T, std::string>) {
-            return arg;
-          }
-          return "";
-        },
-        t_literal_expr->value);
+    symbol_id_t var_name = std::get<symbol_id_t>(t_literal_expr->value);
 
     // Look up the variable in the symbol table
     auto it = named_values.find(var_name);
     if (it != named_values.end()) {
       // Load its value
       llvm::AllocaInst *alloca = it->second;
-      last_value =
-          builder->CreateLoad(alloca->getAllocatedType(), alloca, var_name);
+      last_value = builder->CreateLoad(
+          alloca->getAllocatedType(), alloca,
+          compiler::interner_t::global().spelling(var_name));
       return;
     } else {
       last_value = log_error_v("Unknown variable name");
@@ -107,9 +99,9 @@ void codegen_visitor_t::visit_literal_expr(literal_expr_t *t_literal_expr) {
         } else if constexpr (std::is_same_v<T, char>) {
           return llvm::ConstantInt::get(*context, llvm::APInt(8, arg, true));
         } else if constexpr (std::is_same_v<T, char *> ||
-                             std::is_same_v<T, const std::string &>) {
+                             std::is_same_v<T, std::string_view>) {
           // String literal - create a global string constant
-          return builder->CreateGlobalString(arg, "str");
+          return builder->CreateGlobalString(llvm::StringRef(arg), "str");
         }
         return nullptr;
       },
@@ -244,7 +236,9 @@ void codegen_visitor_t::visit_variable(variable_t *t_variable) {
 
   // Create an alloca for the variable
   llvm::AllocaInst *alloca = create_entry_block_alloca(
-      current_function, t_variable->identifier, var_type);
+      current_function,
+      compiler::interner_t::global().spelling(t_variable->identifier),
+      var_type);
 
   // Generate code for the initializer expression
   if (t_variable->p_expr) {
@@ -285,7 +279,8 @@ void codegen_visitor_t::visit_assign_expr(assign_expr_t *t_assign_expr) {
 
 void codegen_visitor_t::visit_call_expr(call_expr_t *t_call_expr) {
   // Look up the function in the module
-  llvm::Function *callee = module->getFunction(t_call_expr->function_name);
+  llvm::Function *callee = module->getFunction(
+      compiler::interner_t::global().spelling(t_call_expr->function_name));
   if (!callee) {
     last_value = log_error_v("Unknown function referenced");
     return;
@@ -343,9 +338,10 @@ void codegen_visitor_t::visit_function(function_t *t_function) {
       llvm::FunctionType::get(ret_type, param_types, false);
 
   // Create the function
-  llvm::Function *func =
-      llvm::Function::Create(ft, llvm::Function::ExternalLinkage,
-                             t_function->identifier, module.get());
+  llvm::Function *func = llvm::Function::Create(
+      ft, llvm::Function::ExternalLinkage,
+      compiler::interner_t::global().spelling(t_function->identifier),
+      module.get());
 
   // Create entry basic block
   llvm::BasicBlock *bb = llvm::BasicBlock::Create(*context, "entry", func);
@@ -359,20 +355,21 @@ void codegen_visitor_t::visit_function(function_t *t_function) {
   unsigned idx = 0;
   for (auto &arg : func->args()) {
     // Create an alloca for this argument
-    llvm::AllocaInst *alloca = create_entry_block_alloca(
-        func, "arg" + std::to_string(idx), arg.getType());
+    std::string arg_name = "arg" + std::to_string(idx);
+    llvm::AllocaInst *alloca =
+        create_entry_block_alloca(func, arg_name, arg.getType());
 
     // Store the initial value
     builder->CreateStore(&arg, alloca);
 
     // Add to symbol table
-    named_values["arg" + std::to_string(idx)] = alloca;
+    named_values[compiler::interner_t::global().intern(arg_name)] = alloca;
     idx++;
   }
 
   // Generate code for the function body
-  if (t_function->block) {
-    t_function->block->accept_visitor(this);
+  if (t_function->body()) {
+    t_function->body()->accept_visitor(this);
 
     // Verify the function
     if (llvm::verifyFunction(*func, &llvm::errs())) {
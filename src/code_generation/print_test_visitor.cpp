@@ -1,4 +1,5 @@
 #include "code_generation/print_test_visitor.h"
+#include "interner.h"
 #include "parser/abstract_syntax_tree.h"
 #include "tokens.h"
 #include <iostream>
@@ -63,14 +64,16 @@ void print_test_visitor_t::visit_function(
   for (int i = 0; i < t_function->pointer_level; i++) {
     printf("*");
   }
-  printf(" %s(", t_function->identifier.c_str());
+  printf(
+      " %s(",
+      compiler::interner_t::global().spelling(t_function->identifier).c_str());
   for (std::tuple<token_e, int> type_pl :
        *(t_function->parameter_type_pointer_level_tuple)) {
     printf("type: %d pl: %d, ", std::get<token_e>(type_pl),
            std::get<int>(type_pl));
   }
   printf(") ");
-  t_function->block->accept_visitor(this);
+  t_function->body()->accept_visitor(this);
   printf("\n");
 }
 
@@ -80,14 +83,18 @@ void print_test_visitor_t::visit_variable(
   for (int i = 0; i < t_variable->pointer_level; i++) {
     printf("*");
   }
-  printf(" %s = ", t_variable->identifier.c_str());
+  printf(
+      " %s = ",
+      compiler::interner_t::global().spelling(t_variable->identifier).c_str());
   t_variable->p_expr->accept_visitor(this);
   printf(";\n");
 }
 
 void print_test_visitor_t::visit_assign_expr(
     compiler::parser::ast::node::assign_expr_t *t_assign_expr) {
-  printf("%s = ", t_assign_expr->identifier.c_str());
+  printf("%s = ", compiler::interner_t::global()
+                      .spelling(t_assign_expr->identifier)
+                      .c_str());
   t_assign_expr->right->accept_visitor(this);
   printf(" ");
 }
@@ -100,7 +107,9 @@ void print_test_visitor_t::visit_unary_expr(
 
 void print_test_visitor_t::visit_call_expr(
     compiler::parser::ast::node::call_expr_t *t_call_expr) {
-  printf("call(%s ", t_call_expr->function_name.c_str());
+  printf("call(%s ", compiler::interner_t::global()
+                        .spelling(t_call_expr->function_name)
+                        .c_str());
   for (parser::ast::node::expression_t *e : t_call_expr->arguments) {
     e->accept_visitor(this);
   }
@@ -134,7 +143,11 @@ void print_test_visitor_t::visit_literal_expr(
                       [](double v) { std::cout << v << ' '; },
                       [](char v) { std::cout << v << ' '; },
                       [](char *v) { std::cout << v << ' '; },
-                      [](const std::string &v) { std::cout << v << ' '; }},
+                      [](std::string_view v) { std::cout << v << ' '; },
+                      [](compiler::symbol_id_t v) {
+                        std::cout << compiler::interner_t::global().spelling(v)
+                                  << ' ';
+                      }},
              t_literal_expr->value);
 }
 
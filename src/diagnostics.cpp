@@ -0,0 +1,56 @@
+#include "diagnostics.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace compiler {
+
+diagnostics_t::diagnostics_t(size_t limit) {
+  this->_limit = limit;
+  this->_dropped = 0;
+}
+
+void diagnostics_t::report(uint32_t offset, uint32_t length,
+                           std::string message) {
+  if (this->_entries.size() >= this->_limit) {
+    this->_dropped++;
+    return;
+  }
+  this->_entries.push_back(diagnostic_t{offset, length, std::move(message)});
+}
+
+void diagnostics_t::merge(const diagnostics_t &other) {
+  for (const diagnostic_t &diagnostic : other._entries) {
+    this->report(diagnostic.offset, diagnostic.length, diagnostic.message);
+  }
+  this->_dropped += other._dropped;
+}
+
+void diagnostics_t::sort() {
+  std::stable_sort(this->_entries.begin(), this->_entries.end(),
+                   [](const diagnostic_t &a, const diagnostic_t &b) {
+                     return a.offset < b.offset;
+                   });
+}
+
+void diagnostics_t::clear() {
+  this->_entries.clear();
+  this->_dropped = 0;
+}
+
+const std::vector<diagnostic_t> &diagnostics_t::entries() const {
+  return this->_entries;
+}
+
+size_t diagnostics_t::dropped() const { return this->_dropped; }
+
+bool diagnostics_t::empty() const {
+  return this->_entries.empty() && this->_dropped == 0;
+}
+
+size_t diagnostics_t::limit() const { return this->_limit; }
+
+} // namespace compiler
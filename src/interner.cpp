@@ -0,0 +1,39 @@
+#include "interner.h"
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace compiler {
+
+symbol_id_t interner_t::intern(std::string_view t_spelling) {
+  std::lock_guard<std::mutex> lock(this->_mutex);
+
+  std::unordered_map<std::string_view, symbol_id_t>::iterator it =
+      this->_ids.find(t_spelling);
+  if (it != this->_ids.end()) {
+    return it->second;
+  }
+
+  symbol_id_t id = static_cast<symbol_id_t>(this->_spellings.size());
+  this->_spellings.emplace_back(t_spelling);
+  this->_ids.emplace(this->_spellings.back(), id);
+  return id;
+}
+
+const std::string &interner_t::spelling(symbol_id_t id) {
+  std::lock_guard<std::mutex> lock(this->_mutex);
+  return this->_spellings[id];
+}
+
+size_t interner_t::size() {
+  std::lock_guard<std::mutex> lock(this->_mutex);
+  return this->_spellings.size();
+}
+
+interner_t &interner_t::global() {
+  static interner_t interner;
+  return interner;
+}
+
+} // namespace compiler
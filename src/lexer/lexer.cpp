@@ -1,108 +1,735 @@
 #include "lexer/lexer.h"
+#include "diagnostics.h"
+#include "interner.h"
+#include "lexer/scan_kernels.h"
+#include "lexer/token_cache.h"
+#include "source_stream.h"
+#include "thread_pool.h"
+#include "token_buffer.h"
 #include "tokens.h"
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <charconv>
 #include <cstddef>
-#include <cstdio>
-#include <iostream>
-#include <ostream>
-#include <regex>
-// #include <spdlog/fmt/fmt.h>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #include <stdexcept>
+// #include <spdlog/fmt/fmt.h>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
 #include <vector>
 
 namespace compiler::lexer {
 
-std::string remainder(std::string str, int pos) { return str.substr(pos); }
+/** @brief character classes driving the scanner's start state */
+enum char_class_e : uint8_t {
+  cc_invalid,
+  cc_whitespace,
+  cc_newline,
+  cc_ident,
+  cc_digit,
+  cc_dot,
+  cc_slash,
+  cc_double_quote,
+  cc_single_quote,
+  cc_lt,
+  cc_gt,
+  cc_equal,
+  cc_bang,
+  cc_single, ///< one character operator or delimiter
+};
+
+struct char_table_t {
+  std::array<char_class_e, 256> cls;
+  std::array<token_e, 256> single;
+};
+
+constexpr char_table_t make_char_table() {
+  char_table_t t = {};
+  for (int c = 0; c < 256; c++) {
+    t.cls[c] = cc_invalid;
+    t.single[c] = tok_eof;
+  }
+  for (int c = 'a'; c <= 'z'; c++) {
+    t.cls[c] = cc_ident;
+    t.cls[c - 'a' + 'A'] = cc_ident;
+  }
+  for (int c = '0'; c <= '9'; c++) {
+    t.cls[c] = cc_digit;
+  }
+  t.cls['_'] = cc_ident;
+  t.cls[' '] = cc_whitespace;
+  t.cls['\t'] = cc_whitespace;
+  t.cls['\n'] = cc_newline;
+  t.cls['.'] = cc_dot;
+  t.cls['/'] = cc_slash;
+  t.cls['"'] = cc_double_quote;
+  t.cls['\''] = cc_single_quote;
+  t.cls['<'] = cc_lt;
+  t.cls['>'] = cc_gt;
+  t.cls['='] = cc_equal;
+  t.cls['!'] = cc_bang;
+
+  const std::pair<char, token_e> singles[] = {
+      {'+', tok_plus},     {'-', tok_minus},     {'*', tok_star},
+      {'(', tok_lparen},   {')', tok_rparen},    {'{', tok_lbrace},
+      {'}', tok_rbrace},   {'[', tok_lbracket},  {']', tok_rbracket},
+      {',', tok_comma},    {';', tok_semicolon}, {':', tok_colon},
+  };
+  for (const std::pair<char, token_e> &s : singles) {
+    t.cls[static_cast<unsigned char>(s.first)] = cc_single;
+    t.single[static_cast<unsigned char>(s.first)] = s.second;
+  }
+  return t;
+}
 
-bool starts_with_whitespace(std::string str, int *current_linenumber) {
-  if (str.length() <= 0) {
+static constexpr char_table_t char_table = make_char_table();
+
+inline char_class_e char_class(char c) {
+  return char_table.cls[static_cast<unsigned char>(c)];
+}
+
+inline bool is_ident_char(char c) {
+  char_class_e cls = char_class(c);
+  return cls == cc_ident || cls == cc_digit;
+}
+
+inline bool is_digit(char c) { return char_class(c) == cc_digit; }
+
+/**
+ * Runs up to this many bytes are scanned inline, longer ones are handed to
+ * the vector kernels. Most identifiers and separators are only a few bytes
+ * long and for them the indirect call costs more than it saves.
+ */
+static constexpr ptrdiff_t inline_scan_limit = 32;
+
+/** @brief checks whether the 8 bytes at p are all spaces */
+inline bool starts_long_space_run(const char *p, const char *end) {
+  uint64_t word;
+  if (end - p < 8) {
     return false;
   }
+  std::memcpy(&word, p, sizeof(word));
+  return word == 0x2020202020202020ull;
+}
 
-  switch (str.c_str()[0]) {
-  case ' ':
-    return true;
-  case '\n':
-    (*current_linenumber)++;
-    return true;
-  case '\t':
-    return true;
+/** @brief maps a scanned identifier to its keyword token, or tok_id */
+token_e keyword_or_id(const char *p, size_t length) {
+  switch (length) {
+  case 2:
+    if (p[0] == 'i' && p[1] == 'f')
+      return tok_if;
+    break;
+  case 3:
+    if (std::memcmp(p, "int", 3) == 0)
+      return tok_int;
+    if (std::memcmp(p, "for", 3) == 0)
+      return tok_for;
+    break;
+  case 4:
+    if (std::memcmp(p, "bool", 4) == 0)
+      return tok_bool;
+    if (std::memcmp(p, "char", 4) == 0)
+      return tok_char;
+    if (std::memcmp(p, "void", 4) == 0)
+      return tok_void;
+    if (std::memcmp(p, "else", 4) == 0)
+      return tok_else;
+    break;
+  case 5:
+    if (std::memcmp(p, "float", 5) == 0)
+      return tok_float;
+    if (std::memcmp(p, "while", 5) == 0)
+      return tok_while;
+    break;
+  case 6:
+    if (std::memcmp(p, "return", 6) == 0)
+      return tok_return;
+    break;
   default:
     break;
   }
+  return tok_id;
+}
+
+/**
+ * @brief Scans the longest token starting at p
+ *
+ * Implements the rules of the token specification in tokens.h as a single
+ * deterministic pass: the first byte selects the state, the following bytes
+ * extend the match as far as possible (maximal munch). When several rules
+ * match the same length, the one declared first in token_e wins, which is how
+ * keywords take priority over identifiers.
+ *
+ * @return number of bytes matched, 0 if no rule matches
+ */
+size_t scan_token(const char *p, const char *end, token_e *kind,
+                  const scan_kernels_t &kernels) {
+  const char *start = p;
+  const char *limit;
+
+  switch (char_class(*p)) {
+  case cc_ident:
+    // most identifiers are short, only long ones go to the vector kernel
+    limit = end - p > inline_scan_limit ? p + inline_scan_limit : end;
+    p++;
+    while (p < limit && is_ident_char(*p)) p++;
+    if (p == limit && p < end && is_ident_char(*p)) {
+      p = kernels.skip_identifier(p, end);
+    }
+    *kind = keyword_or_id(start, p - start);
+    return p - start;
+
+  case cc_digit:
+    // \d+\.\d+|\d+
+    while (p < end && is_digit(*p)) p++;
+    *kind = tok_number;
+    if (p + 1 < end && *p == '.' && is_digit(p[1])) {
+      p += 2;
+      while (p < end && is_digit(*p)) p++;
+      *kind = tok_float_literal;
+    }
+    return p - start;
+
+  case cc_dot:
+    // \.\d+
+    if (p + 1 < end && is_digit(p[1])) {
+      p += 2;
+      while (p < end && is_digit(*p)) p++;
+      *kind = tok_float_literal;
+      return p - start;
+    }
+    return 0;
+
+  case cc_slash:
+    // //[^\r\n]*
+    if (p + 1 < end && p[1] == '/') {
+      limit = end - p > inline_scan_limit ? p + inline_scan_limit : end;
+      p += 2;
+      while (p < limit && *p != '\n' && *p != '\r') p++;
+      if (p == limit && p < end && *p != '\n' && *p != '\r') {
+        p = kernels.find_line_end(p, end);
+      }
+      *kind = tok_comment;
+      return p - start;
+    }
+    *kind = tok_slash;
+    return 1;
+
+  case cc_double_quote:
+    // ".*?" - the shortest match, '.' excludes line terminators
+    for (p++; p < end && *p != '\n' && *p != '\r'; p++) {
+      if (*p == '"') {
+        *kind = tok_string;
+        return p + 1 - start;
+      }
+    }
+    return 0;
+
+  case cc_single_quote:
+    // '.'
+    if (p + 2 < end && p[1] != '\n' && p[1] != '\r' && p[2] == '\'') {
+      *kind = tok_char_literal;
+      return 3;
+    }
+    return 0;
+
+  case cc_lt:
+    if (p + 1 < end && p[1] == '=') {
+      *kind = tok_leq;
+      return 2;
+    }
+    *kind = tok_lt;
+    return 1;
+
+  case cc_gt:
+    if (p + 1 < end && p[1] == '=') {
+      *kind = tok_geq;
+      return 2;
+    }
+    *kind = tok_gt;
+    return 1;
+
+  case cc_equal:
+    if (p + 1 < end && p[1] == '=') {
+      *kind = tok_eq;
+      return 2;
+    }
+    *kind = tok_assign;
+    return 1;
+
+  case cc_bang:
+    if (p + 1 < end && p[1] == '=') {
+      *kind = tok_neq;
+      return 2;
+    }
+    *kind = tok_exclaimationmark;
+    return 1;
+
+  case cc_single:
+    *kind = char_table.single[static_cast<unsigned char>(*p)];
+    return 1;
+
+  case cc_whitespace:
+  case cc_newline:
+  case cc_invalid:
+    break;
+  }
+  return 0;
+}
+
+lexer_t::lexer_t() {
+  this->current_offset = 0;
+  this->_p_kernels = &scan_kernels();
+  this->_p_stream = nullptr;
+  this->_window_offset = 0;
+  this->_ring_head = 0;
+  this->_ring_size = 0;
+}
+
+lexer_t::lexer_t(std::string_view source) : lexer_t() {
+  if (source.length() >= UINT32_MAX) {
+    throw std::runtime_error("Source is too large to lex");
+  }
+  this->set_source(source);
+}
 
-  return false;
+lexer_t::lexer_t(source_stream_t &stream) : lexer_t() {
+  this->_p_stream = &stream;
 }
 
-lexer_t::lexer_t() { this->current_linenumber = 1; }
+size_t lexer::lexer_t::get_offset() {
+  return this->_window_offset + this->current_offset;
+}
+
+void lexer_t::set_source(std::string_view source) {
+  // the cache keys are views into the previous source, which may be gone
+  this->_symbol_cache.clear();
+  this->_diagnostics.clear();
+  this->_p_stream = nullptr;
+  this->_window_offset = 0;
+  this->_t_source = source;
+}
 
-int lexer::lexer_t::get_linenumber() { return this->current_linenumber; }
+/**
+ * @brief Makes the next complete lines of the stream available to scan()
+ *
+ * Called once the cursor reached the end of the lexable part of the window.
+ * Bytes in front of the oldest token that is still needed are dropped,
+ * then chunks are read until a newline arrives or the stream ends. No token
+ * spans a newline, so the window can always be cut after one.
+ *
+ * @return false if there was nothing left to read, the window is unchanged
+ */
+bool lexer_t::refill() {
+  if (this->_p_stream == nullptr || this->_p_stream->at_end()) {
+    return false;
+  }
 
-std::vector<token_t *> lexer_t::lex(std::string source) {
-  size_t pos = 0;
-  std::vector<token_t *> tokens;
+  size_t keep = this->current_offset;
+  if (this->_ring_size > 0) {
+    keep = this->_ring[this->_ring_head].offset - this->_window_offset;
+  }
+  this->_t_window.erase(0, keep);
+  this->_window_offset += keep;
+  this->current_offset -= keep;
 
-  while (pos < source.length()) {
-    std::string rest = remainder(source, pos);
+  // everything up to the cursor has been lexed, so new lines end in new bytes
+  size_t lexable = this->current_offset;
+  while (true) {
+    size_t old_size = this->_t_window.length();
+    if (this->_p_stream->read_chunk(&this->_t_window) == 0) {
+      lexable = this->_t_window.length();
+      break;
+    }
+    std::string_view fresh =
+        std::string_view(this->_t_window).substr(old_size);
+    size_t newline = fresh.rfind('\n');
+    if (newline != std::string_view::npos) {
+      lexable = old_size + newline + 1;
+      break;
+    }
+  }
+  if (this->_window_offset + this->_t_window.length() >= UINT32_MAX) {
+    throw std::runtime_error("Source is too large to lex");
+  }
+
+  // the window may have moved, views into it are stale
+  this->_symbol_cache.clear();
+  this->_t_source = std::string_view(this->_t_window.data(), lexable);
+  for (size_t i = 0; i < this->_ring_size; i++) {
+    token_t &tok = this->_ring[(this->_ring_head + i) % max_lookahead];
+    tok.t_val = this->_t_source.substr(tok.offset - this->_window_offset,
+                                       tok.t_val.length());
+  }
+  return true;
+}
+
+const diagnostics_t &lexer_t::diagnostics() const { return this->_diagnostics; }
+
+token_value_t lexer_t::decode(token_e kind, uint32_t offset,
+                              uint32_t length) {
+  const char *p = this->_t_source.data() + offset;
+  uint32_t position = static_cast<uint32_t>(this->_window_offset + offset);
+  token_value_t value = token_value_t{no_symbol};
+
+  switch (kind) {
+  case tok_id: {
+    std::string_view lexeme = std::string_view(p, length);
+    std::unordered_map<std::string_view, symbol_id_t>::iterator it =
+        this->_symbol_cache.find(lexeme);
+    if (it != this->_symbol_cache.end()) {
+      value.symbol = it->second;
+    } else {
+      value.symbol = interner_t::global().intern(lexeme);
+      this->_symbol_cache.emplace(lexeme, value.symbol);
+    }
+    break;
+  }
+  case tok_number:
+    // the scanner only lets digits through, so range is the only failure
+    if (std::from_chars(p, p + length, value.integer).ec != std::errc()) {
+      this->_diagnostics.report(position, length,
+                                "integer literal out of range");
+      value.integer = INT32_MAX;
+    }
+    break;
+  case tok_float_literal:
+    if (std::from_chars(p, p + length, value.real).ec != std::errc()) {
+      this->_diagnostics.report(position, length, "float literal out of range");
+      // only a nonzero integer part can overflow, anything else underflowed
+      const char *q = p;
+      while (*q == '0') q++;
+      value.real = *q == '.' ? 0.0f : std::numeric_limits<float>::infinity();
+    }
+    break;
+  case tok_error:
+    this->_diagnostics.report(position, length,
+                              length == 1 ? "unexpected character"
+                                          : "unexpected characters");
+    break;
+  default:
+    break;
+  }
+  return value;
+}
+
+/**
+ * @brief Finds the next token at or after *p_current
+ *
+ * Skips whitespace and comments, then advances the cursor past the token.
+ * Shared by lex() and the streaming interface; inlined so lex() can keep the
+ * cursor in registers.
+ *
+ * Bytes no rule matches become a tok_error. It extends over the following
+ * bytes up to the next whitespace or the next byte a token can start at, so
+ * scanning resumes at the next plausible token and never crosses a line.
+ *
+ * @return kind of the token, tok_eof at the end of the source
+ */
+__attribute__((always_inline)) inline token_e
+next_token_at(const char *begin, const char *end, size_t *p_current,
+              const scan_kernels_t &kernels, uint32_t *offset,
+              uint32_t *length) {
+  size_t current = *p_current;
+  size_t size = end - begin;
+
+  while (current < size) {
+    const char *p = begin + current;
 
     // remove whitespace
-    if (starts_with_whitespace(rest, &(this->current_linenumber))) {
-      pos++;
+    switch (char_class(*p)) {
+    case cc_newline:
+      current++;
+      // deep indentation goes to the vector kernel
+      if (starts_long_space_run(p + 1, end)) {
+        current = kernels.skip_whitespace(p + 9, end) - begin;
+      }
+      continue;
+    case cc_whitespace:
+      current++;
       continue;
+    default:
+      break;
     }
 
     // parse token
-    bool token_found = false;
-    for (std::pair<token_e, std::regex> pair : token_regex) {
-      std::smatch match;
-      std::regex reg = pair.second;
-      if (std::regex_search(rest, match, reg,
-                            std::regex_constants::match_continuous)) {
-        if (pair.first != tok_comment) {
-          tokens.push_back(
-              create_token_t(pair.first, match.str(), this->get_linenumber()));
+    token_e kind = tok_eof;
+    size_t n = scan_token(p, end, &kind, kernels);
+    if (n == 0) {
+      size_t error_end = current + 1;
+      while (error_end < size) {
+        char_class_e cls = char_class(begin[error_end]);
+        if (cls == cc_whitespace || cls == cc_newline ||
+            scan_token(begin + error_end, end, &kind, kernels) != 0) {
+          break;
         }
-        pos += match.length(0);
-        token_found = true;
-        break;
+        error_end++;
       }
+      *offset = static_cast<uint32_t>(current);
+      *length = static_cast<uint32_t>(error_end - current);
+      *p_current = error_end;
+      return tok_error;
     }
-    if (!token_found) {
-      std::cout << "no token found: " << rest << std::endl;
+    if (kind == tok_comment) {
+      current += n;
+      continue;
+    }
+
+    *offset = static_cast<uint32_t>(current);
+    *length = static_cast<uint32_t>(n);
+    *p_current = current + n;
+    return kind;
+  }
+
+  *offset = static_cast<uint32_t>(current);
+  *length = 0;
+  *p_current = current;
+  return tok_eof;
+}
+
+token_e lexer_t::scan(uint32_t *offset, uint32_t *length) {
+  while (true) {
+    const char *begin = this->_t_source.data();
+    token_e kind = next_token_at(begin, begin + this->_t_source.length(),
+                                 &this->current_offset, *this->_p_kernels,
+                                 offset, length);
+    if (kind != tok_eof || !this->refill()) {
+      return kind;
     }
   }
+}
+
+token_buffer_t lexer_t::lex(std::string_view source) {
+  return this->lex_range(source, 0, source.length());
+}
+
+token_buffer_t lexer_t::lex_range(std::string_view source, size_t first,
+                                  size_t last) {
+  if (source.length() >= UINT32_MAX) {
+    throw std::runtime_error("Source is too large to lex");
+  }
+  assert(first <= last && last <= source.length());
+
+  token_buffer_t tokens = token_buffer_t(source);
+  // rough guess of one token per 4 bytes to avoid regrowing the arrays
+  tokens.reserve((last - first) / 4 + 1);
+
+  this->set_source(source);
+  this->_ring_head = 0;
+  this->_ring_size = 0;
+
+  const char *begin = source.data();
+  const char *end = begin + last;
+  const scan_kernels_t &kernels = *this->_p_kernels;
+  size_t current = first;
 
-  tokens.push_back(new token_t(tok_eof, "", this->get_linenumber()));
+  token_e kind;
+  do {
+    uint32_t offset;
+    uint32_t length;
+    kind = next_token_at(begin, end, &current, kernels, &offset, &length);
+    tokens.push_back(kind, offset, length, this->decode(kind, offset, length));
+  } while (kind != tok_eof);
+
+  this->current_offset = current;
   return tokens;
 }
 
-std::vector<token_t *> lex_file(std::string t_input_file_path) {
-  // open file
-  FILE *tp_file = fopen(t_input_file_path.c_str(), "rb");
-  if (tp_file == NULL) {
-    throw std::runtime_error("Failed to open file: " + t_input_file_path);
+token_buffer_t lexer_t::relex(token_buffer_t previous, std::string_view source,
+                              const source_edit_t &edit, token_diff_t *p_diff) {
+  if (source.length() >= UINT32_MAX) {
+    throw std::runtime_error("Source is too large to lex");
+  }
+  size_t old_length =
+      source.length() - edit.inserted_length + edit.removed_length;
+  if (previous.empty() ||
+      edit.offset + edit.inserted_length > source.length() ||
+      previous.offset(previous.size() - 1) != old_length) {
+    throw std::out_of_range("Edit does not fit the previous token stream");
   }
 
-  // get file size
-  fseek(tp_file, 0, SEEK_END);
-  long file_size = ftell(tp_file);
-  fseek(tp_file, 0, SEEK_SET);
+  // no token spans a newline, so lexing can restart at the edited line
+  size_t line_start = 0;
+  if (edit.offset > 0) {
+    size_t newline = source.rfind('\n', edit.offset - 1);
+    line_start = newline == std::string_view::npos ? 0 : newline + 1;
+  }
+
+  const uint32_t *p_offsets = previous.offsets();
+  token_index_t first = static_cast<token_index_t>(
+      std::lower_bound(p_offsets, p_offsets + previous.size(), line_start) -
+      p_offsets);
+
+  // relex until a token starts where an old one started behind the edit
+  this->set_source(source);
+  token_buffer_t replacement = token_buffer_t(source);
+  size_t edit_end = edit.offset + edit.inserted_length;
+  size_t current = line_start;
+  token_index_t resync = first;
+  const char *begin = source.data();
+  const char *end = begin + source.length();
+  while (true) {
+    uint32_t offset;
+    uint32_t length;
+    token_e kind = next_token_at(begin, end, &current, *this->_p_kernels,
+                                 &offset, &length);
 
-  // allocate buffer and read file
-  std::string source;
-  source.resize(file_size);
-  size_t bytes_read = fread(&source[0], 1, file_size, tp_file);
-  fclose(tp_file);
+    if (offset >= edit_end) {
+      size_t old_offset = offset - edit.inserted_length + edit.removed_length;
+      while (p_offsets[resync] < old_offset) {
+        resync++;
+      }
+      if (p_offsets[resync] == old_offset) {
+        break;
+      }
+    }
 
-  if (bytes_read != static_cast<size_t>(file_size)) {
-    throw std::runtime_error("Failed to read entire file: " +
-                             t_input_file_path);
+    // tokens in front of the edit that come out unchanged are not part of
+    // the diff
+    if (replacement.empty() && offset + length <= edit.offset &&
+        kind == previous.kind(first) && offset == p_offsets[first] &&
+        length == previous.length(first)) {
+      first++;
+      resync = first;
+      continue;
+    }
+    replacement.push_back(kind, offset, length,
+                          this->decode(kind, offset, length));
+  }
+
+  if (p_diff != nullptr) {
+    p_diff->first = first;
+    p_diff->removed = resync - first;
+    p_diff->inserted = replacement.size();
+  }
+
+  int64_t offset_delta = static_cast<int64_t>(edit.inserted_length) -
+                         static_cast<int64_t>(edit.removed_length);
+  previous.splice(source, first, resync - first, replacement, offset_delta);
+  return previous;
+}
+
+token_t lexer_t::next_token() {
+  if (this->_ring_size > 0) {
+    token_t tok = this->_ring[this->_ring_head];
+    this->_ring_head = (this->_ring_head + 1) % max_lookahead;
+    this->_ring_size--;
+    return tok;
   }
 
-  // lex source
-  lexer_t lxr = lexer_t();
-  std::vector<token_t *> tokens = lxr.lex(source);
+  uint32_t offset;
+  uint32_t length;
+  token_e kind = this->scan(&offset, &length);
+  return token_t(kind, this->_t_source.substr(offset, length),
+                 static_cast<uint32_t>(this->_window_offset + offset),
+                 this->decode(kind, offset, length));
+}
+
+const token_t &lexer_t::peek(size_t k) {
+  if (k >= max_lookahead) {
+    throw std::out_of_range("peek beyond the lexer lookahead");
+  }
+
+  while (this->_ring_size <= k) {
+    uint32_t offset;
+    uint32_t length;
+    token_e kind = this->scan(&offset, &length);
+    size_t slot = (this->_ring_head + this->_ring_size) % max_lookahead;
+    this->_ring[slot] =
+        token_t(kind, this->_t_source.substr(offset, length),
+                static_cast<uint32_t>(this->_window_offset + offset),
+                this->decode(kind, offset, length));
+    this->_ring_size++;
+  }
+  return this->_ring[(this->_ring_head + k) % max_lookahead];
+}
+
+token_buffer_t lex_parallel(std::string_view source, thread_pool_t &pool,
+                            size_t n_chunks, diagnostics_t *p_diagnostics) {
+  if (source.length() >= UINT32_MAX) {
+    throw std::runtime_error("Source is too large to lex");
+  }
+
+  // cut right after a newline: no token spans one, so every chunk starts in
+  // the scanner's initial state, even inside comments and string literals
+  std::vector<size_t> cuts = {0};
+  size_t chunk_size = source.length() / std::max<size_t>(n_chunks, 1) + 1;
+  while (cuts.back() < source.length()) {
+    size_t cut = cuts.back() + chunk_size;
+    if (cut >= source.length()) {
+      cut = source.length();
+    } else {
+      size_t newline = source.find('\n', cut - 1);
+      cut = newline == std::string_view::npos ? source.length() : newline + 1;
+    }
+    cuts.push_back(cut);
+  }
+  if (cuts.size() == 1) {
+    cuts.push_back(0);
+  }
+
+  size_t n = cuts.size() - 1;
+  std::vector<token_buffer_t> chunks(n);
+  std::vector<diagnostics_t> chunk_diagnostics(n);
+  pool.parallel_for(n, [&](size_t i) {
+    lexer_t lxr = lexer_t();
+    chunks[i] = lxr.lex_range(source, cuts[i], cuts[i + 1]);
+    chunk_diagnostics[i] = lxr.diagnostics();
+  });
+
+  if (p_diagnostics != nullptr) {
+    for (const diagnostics_t &diagnostics : chunk_diagnostics) {
+      p_diagnostics->merge(diagnostics);
+    }
+  }
+
+  // stitch, dropping the eof of all but the last chunk
+  size_t total = 1;
+  for (const token_buffer_t &chunk : chunks) {
+    total += chunk.size() - 1;
+  }
+  token_buffer_t tokens = token_buffer_t(source);
+  tokens.reserve(total);
+
+  for (size_t i = 0; i < n; i++) {
+    token_index_t count = chunks[i].size() - (i + 1 < n ? 1 : 0);
+    tokens.append(chunks[i], count);
+  }
+  return tokens;
+}
+
+token_buffer_t lex_file(const source_buffer_t &t_source,
+                        diagnostics_t *p_diagnostics,
+                        const token_cache_t *p_cache) {
+  token_buffer_t tokens;
+  if (p_cache != nullptr && p_cache->load(t_source.view(), &tokens)) {
+    return tokens;
+  }
+
+  diagnostics_t diagnostics = diagnostics_t();
+  thread_pool_t &pool = thread_pool_t::shared();
+  if (t_source.size() >= parallel_lex_threshold && pool.size() > 1) {
+    // a few chunks per thread even out lines of different density
+    tokens = lex_parallel(t_source.view(), pool, pool.size() * 4,
+                          &diagnostics);
+  } else {
+    lexer_t lxr = lexer_t();
+    tokens = lxr.lex(t_source.view());
+    diagnostics = lxr.diagnostics();
+  }
+
+  // a hit could not report the errors again, so only clean streams are kept
+  if (p_cache != nullptr && diagnostics.empty()) {
+    p_cache->store(t_source.view(), tokens);
+  }
+  if (p_diagnostics != nullptr) {
+    p_diagnostics->merge(diagnostics);
+  }
   return tokens;
 }
 
@@ -0,0 +1,299 @@
+#include "lexer/scan_kernels.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__)
+#define SCAN_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace compiler::lexer {
+
+// ---------------------------------------------------------------- scalar
+
+inline bool is_whitespace_byte(char c) {
+  return c == ' ' || c == '\t' || c == '\n';
+}
+
+inline bool is_identifier_byte(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_';
+}
+
+const char *scalar_skip_whitespace(const char *p, const char *end) {
+  while (p < end && is_whitespace_byte(*p)) p++;
+  return p;
+}
+
+const char *scalar_skip_identifier(const char *p, const char *end) {
+  while (p < end && is_identifier_byte(*p)) p++;
+  return p;
+}
+
+const char *scalar_find_line_end(const char *p, const char *end) {
+  while (p < end && *p != '\n' && *p != '\r') p++;
+  return p;
+}
+
+size_t scalar_count_newlines(const char *p, const char *end) {
+  size_t lines = 0;
+  for (; p < end; p++) {
+    lines += *p == '\n';
+  }
+  return lines;
+}
+
+size_t scalar_find_newlines(const char *p, const char *end, uint32_t base,
+                            uint32_t *p_out) {
+  size_t n = 0;
+  for (const char *start = p; p < end; p++) {
+    if (*p == '\n') {
+      p_out[n++] = base + static_cast<uint32_t>(p - start);
+    }
+  }
+  return n;
+}
+
+static const scan_kernels_t scalar_kernels = {
+    "scalar",
+    scalar_skip_whitespace,
+    scalar_skip_identifier,
+    scalar_find_line_end,
+    scalar_count_newlines,
+    scalar_find_newlines,
+};
+
+#ifdef SCAN_KERNELS_X86
+
+// ------------------------------------------------------------------ sse2
+//
+// Each step compares 16 bytes at once and turns the result into a bit mask,
+// bit i set when byte i belongs to the run. The first clear bit ends the run
+// and popcount over the '\n' mask counts lines. Tails shorter than a vector
+// fall back to the scalar loops so no load crosses the end of the input.
+
+inline uint32_t sse2_whitespace_mask(__m128i v) {
+  __m128i nl = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+  __m128i ws = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                            _mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+  return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(ws, nl)));
+}
+
+// appends base + index for every set bit of mask
+inline size_t collect_bits(uint32_t mask, uint32_t base, uint32_t *p_out) {
+  size_t n = 0;
+  while (mask != 0) {
+    p_out[n++] = base + __builtin_ctz(mask);
+    mask &= mask - 1;
+  }
+  return n;
+}
+
+// x is in [lo, lo + span] iff the unsigned byte x - lo is at most span
+inline __m128i sse2_in_range(__m128i v, char lo, char span) {
+  __m128i d = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+  return _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(span)), d);
+}
+
+inline uint32_t sse2_identifier_mask(__m128i v) {
+  // folding case with | 0x20 maps no other byte into a-z
+  __m128i folded = _mm_or_si128(v, _mm_set1_epi8(0x20));
+  __m128i alpha = sse2_in_range(folded, 'a', 25);
+  __m128i digit = sse2_in_range(v, '0', 9);
+  __m128i under = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+  return static_cast<uint32_t>(
+      _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(alpha, digit), under)));
+}
+
+const char *sse2_skip_whitespace(const char *p, const char *end) {
+  while (end - p >= 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    uint32_t outside = ~sse2_whitespace_mask(v) & 0xffff;
+    if (outside != 0) {
+      return p + __builtin_ctz(outside);
+    }
+    p += 16;
+  }
+  return scalar_skip_whitespace(p, end);
+}
+
+const char *sse2_skip_identifier(const char *p, const char *end) {
+  while (end - p >= 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    uint32_t outside = ~sse2_identifier_mask(v) & 0xffff;
+    if (outside != 0) {
+      return p + __builtin_ctz(outside);
+    }
+    p += 16;
+  }
+  return scalar_skip_identifier(p, end);
+}
+
+const char *sse2_find_line_end(const char *p, const char *end) {
+  while (end - p >= 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')),
+                               _mm_cmpeq_epi8(v, _mm_set1_epi8('\r')));
+    uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hit));
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 16;
+  }
+  return scalar_find_line_end(p, end);
+}
+
+size_t sse2_count_newlines(const char *p, const char *end) {
+  size_t lines = 0;
+  while (end - p >= 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    lines += __builtin_popcount(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+    p += 16;
+  }
+  return lines + scalar_count_newlines(p, end);
+}
+
+size_t sse2_find_newlines(const char *p, const char *end, uint32_t base,
+                          uint32_t *p_out) {
+  size_t n = 0;
+  const char *start = p;
+  while (end - p >= 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    uint32_t mask = static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+    n += collect_bits(mask, base + static_cast<uint32_t>(p - start), p_out + n);
+    p += 16;
+  }
+  uint32_t offset = base + static_cast<uint32_t>(p - start);
+  return n + scalar_find_newlines(p, end, offset, p_out + n);
+}
+
+static const scan_kernels_t sse2_kernels = {
+    "sse2",
+    sse2_skip_whitespace,
+    sse2_skip_identifier,
+    sse2_find_line_end,
+    sse2_count_newlines,
+    sse2_find_newlines,
+};
+
+// ------------------------------------------------------------------ avx2
+//
+// Same algorithms on 32 byte vectors. The functions are compiled for AVX2
+// individually, so the rest of the program still runs on any x86-64 CPU.
+
+#define AVX2_TARGET __attribute__((target("avx2,popcnt,bmi")))
+
+AVX2_TARGET inline __m256i avx2_in_range(__m256i v, char lo, char span) {
+  __m256i d = _mm256_sub_epi8(v, _mm256_set1_epi8(lo));
+  return _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(span)), d);
+}
+
+AVX2_TARGET const char *avx2_skip_whitespace(const char *p, const char *end) {
+  while (end - p >= 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i nl = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'));
+    __m256i ws = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                                 _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')));
+    uint32_t outside =
+        ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(ws, nl)));
+    if (outside != 0) {
+      return p + __builtin_ctz(outside);
+    }
+    p += 32;
+  }
+  return sse2_skip_whitespace(p, end);
+}
+
+AVX2_TARGET const char *avx2_skip_identifier(const char *p, const char *end) {
+  while (end - p >= 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i alpha =
+        avx2_in_range(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 25);
+    __m256i digit = avx2_in_range(v, '0', 9);
+    __m256i under = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+    uint32_t outside = ~static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_or_si256(_mm256_or_si256(alpha, digit), under)));
+    if (outside != 0) {
+      return p + __builtin_ctz(outside);
+    }
+    p += 32;
+  }
+  return sse2_skip_identifier(p, end);
+}
+
+AVX2_TARGET const char *avx2_find_line_end(const char *p, const char *end) {
+  while (end - p >= 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i hit =
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')),
+                        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')));
+    uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 32;
+  }
+  return sse2_find_line_end(p, end);
+}
+
+AVX2_TARGET size_t avx2_count_newlines(const char *p, const char *end) {
+  size_t lines = 0;
+  while (end - p >= 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    lines += __builtin_popcount(static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')))));
+    p += 32;
+  }
+  return lines + sse2_count_newlines(p, end);
+}
+
+AVX2_TARGET size_t avx2_find_newlines(const char *p, const char *end,
+                                      uint32_t base, uint32_t *p_out) {
+  size_t n = 0;
+  const char *start = p;
+  while (end - p >= 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    uint32_t mask = static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))));
+    n += collect_bits(mask, base + static_cast<uint32_t>(p - start), p_out + n);
+    p += 32;
+  }
+  return n + sse2_find_newlines(p, end, base + static_cast<uint32_t>(p - start),
+                                p_out + n);
+}
+
+static const scan_kernels_t avx2_kernels = {
+    "avx2",
+    avx2_skip_whitespace,
+    avx2_skip_identifier,
+    avx2_find_line_end,
+    avx2_count_newlines,
+    avx2_find_newlines,
+};
+
+#endif // SCAN_KERNELS_X86
+
+const scan_kernels_t &scalar_scan_kernels() { return scalar_kernels; }
+
+std::vector<const scan_kernels_t *> supported_scan_kernels() {
+  std::vector<const scan_kernels_t *> kernels = {&scalar_kernels};
+#ifdef SCAN_KERNELS_X86
+  // sse2 is part of the x86-64 baseline
+  kernels.push_back(&sse2_kernels);
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt") &&
+      __builtin_cpu_supports("bmi")) {
+    kernels.push_back(&avx2_kernels);
+  }
+#endif
+  return kernels;
+}
+
+const scan_kernels_t &scan_kernels() {
+  static const scan_kernels_t *p_best = supported_scan_kernels().back();
+  return *p_best;
+}
+
+} // namespace compiler::lexer
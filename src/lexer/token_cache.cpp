@@ -0,0 +1,252 @@
+#include "lexer/token_cache.h"
+#include "interner.h"
+#include "token_buffer.h"
+#include "tokens.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace compiler::lexer {
+
+/**
+ * @brief Layout of the start of a cache entry
+ *
+ * Followed by the offsets, lengths and values of token_count tokens, the
+ * first token of each of symbol_count identifiers and finally the kinds.
+ * The 4-byte arrays come first so all of them stay aligned in the mapping.
+ */
+struct cache_header_t {
+  char magic[4];
+  uint32_t version;
+  uint64_t hash;
+  uint64_t source_size;
+  uint32_t token_count;
+  uint32_t symbol_count;
+};
+
+static_assert(sizeof(token_value_t) == sizeof(uint32_t),
+              "cache entries store one 32-bit value per token");
+
+static constexpr char cache_magic[4] = {'L', 'T', 'O', 'K'};
+
+inline uint64_t rotate_left(uint64_t x, int r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+uint64_t content_hash(std::string_view data, uint64_t seed) {
+  const uint64_t k1 = 0x9e3779b97f4a7c15ull;
+  const uint64_t k2 = 0xc2b2ae3d27d4eb4full;
+  const char *p = data.data();
+  size_t n = data.length();
+  size_t i = 0;
+  uint64_t word;
+
+  uint64_t lanes[4] = {seed + k1, seed ^ k2, seed, seed - k1};
+  for (; i + 32 <= n; i += 32) {
+    for (int lane = 0; lane < 4; lane++) {
+      std::memcpy(&word, p + i + 8 * lane, sizeof(word));
+      lanes[lane] = rotate_left(lanes[lane] ^ (word * k2), 31) * k1;
+    }
+  }
+  uint64_t h = rotate_left(lanes[0], 1) + rotate_left(lanes[1], 7) +
+               rotate_left(lanes[2], 12) + rotate_left(lanes[3], 18) + n;
+
+  for (; i + 8 <= n; i += 8) {
+    std::memcpy(&word, p + i, sizeof(word));
+    h = rotate_left(h ^ (word * k2), 27) * k1;
+  }
+  for (; i < n; i++) {
+    h = rotate_left(h ^ static_cast<uint8_t>(p[i]), 11) * k1;
+  }
+
+  // final mix so every input bit reaches every output bit
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+static std::string entry_path_of(const std::string &t_directory,
+                                 uint64_t hash) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.tokens",
+                static_cast<unsigned long long>(hash));
+  return t_directory + "/" + name;
+}
+
+/**
+ * @brief Rebuilds the tokens of a mapped entry
+ * @return false if the entry does not belong to the source or is damaged
+ */
+static bool decode_entry(const char *p_entry, size_t size,
+                         std::string_view source, uint64_t hash,
+                         token_buffer_t *p_tokens) {
+  cache_header_t header;
+  if (size < sizeof(header)) {
+    return false;
+  }
+  std::memcpy(&header, p_entry, sizeof(header));
+  size_t n = header.token_count;
+  size_t expected_size = sizeof(header) + n * 3 * sizeof(uint32_t) +
+                         header.symbol_count * sizeof(uint32_t) + n;
+  if (std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0 ||
+      header.version != lexer_version || header.hash != hash ||
+      header.source_size != source.length() || size != expected_size ||
+      n == 0) {
+    return false;
+  }
+
+  const char *p = p_entry + sizeof(header);
+  const uint32_t *p_offsets = reinterpret_cast<const uint32_t *>(p);
+  const uint32_t *p_lengths = p_offsets + n;
+  const token_value_t *p_values =
+      reinterpret_cast<const token_value_t *>(p_lengths + n);
+  const uint32_t *p_first_use =
+      reinterpret_cast<const uint32_t *>(p_values + n);
+  const uint8_t *p_kinds =
+      reinterpret_cast<const uint8_t *>(p_first_use + header.symbol_count);
+
+  // intern each distinct identifier once, then point the tokens at the IDs
+  std::vector<symbol_id_t> ids(header.symbol_count);
+  for (size_t s = 0; s < ids.size(); s++) {
+    uint32_t i = p_first_use[s];
+    if (i >= n || p_offsets[i] > source.length() ||
+        p_lengths[i] > source.length() - p_offsets[i]) {
+      return false;
+    }
+    ids[s] = interner_t::global().intern(
+        source.substr(p_offsets[i], p_lengths[i]));
+  }
+
+  token_buffer_t tokens = token_buffer_t(source);
+  tokens.assign(p_kinds, p_offsets, p_lengths, p_values,
+                static_cast<token_index_t>(n));
+  for (token_index_t i = 0; i < tokens.size(); i++) {
+    if (tokens.kind(i) >= token_kind_count ||
+        tokens.offset(i) > source.length() ||
+        tokens.length(i) > source.length() - tokens.offset(i)) {
+      return false;
+    }
+    if (tokens.kind(i) == tok_id) {
+      symbol_id_t local = tokens.symbol(i);
+      if (local >= ids.size()) {
+        return false;
+      }
+      tokens.value_at(i).symbol = ids[local];
+    }
+  }
+
+  *p_tokens = std::move(tokens);
+  return true;
+}
+
+token_cache_t::token_cache_t(const std::string &t_directory) {
+  this->_t_directory = t_directory;
+  // a directory that cannot be created just makes every lookup miss
+  std::error_code ec;
+  std::filesystem::create_directories(t_directory, ec);
+}
+
+std::string token_cache_t::entry_path(std::string_view source) const {
+  return entry_path_of(this->_t_directory,
+                       content_hash(source, lexer_version));
+}
+
+bool token_cache_t::load(std::string_view source,
+                         token_buffer_t *p_tokens) const {
+  uint64_t hash = content_hash(source, lexer_version);
+  std::string path = entry_path_of(this->_t_directory, hash);
+
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    close(fd);
+    return false;
+  }
+  void *p_mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (p_mapping == MAP_FAILED) {
+    return false;
+  }
+
+  bool hit = decode_entry(static_cast<const char *>(p_mapping), st.st_size,
+                          source, hash, p_tokens);
+  munmap(p_mapping, st.st_size);
+  return hit;
+}
+
+bool token_cache_t::store(std::string_view source,
+                          const token_buffer_t &tokens) const {
+  // replace the process local symbol IDs by dense per-entry ones
+  size_t n = tokens.size();
+  std::vector<token_value_t> values(tokens.values(), tokens.values() + n);
+  std::vector<uint32_t> first_use;
+  std::unordered_map<symbol_id_t, uint32_t> local_ids;
+  for (token_index_t i = 0; i < n; i++) {
+    if (tokens.kind(i) != tok_id) {
+      continue;
+    }
+    std::pair<std::unordered_map<symbol_id_t, uint32_t>::iterator, bool> it =
+        local_ids.emplace(values[i].symbol,
+                          static_cast<uint32_t>(first_use.size()));
+    if (it.second) {
+      first_use.push_back(i);
+    }
+    values[i].symbol = it.first->second;
+  }
+
+  cache_header_t header;
+  std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+  header.version = lexer_version;
+  header.hash = content_hash(source, lexer_version);
+  header.source_size = source.length();
+  header.token_count = static_cast<uint32_t>(n);
+  header.symbol_count = static_cast<uint32_t>(first_use.size());
+
+  std::string path = entry_path_of(this->_t_directory, header.hash);
+  std::string tmp_path = path + ".tmp" + std::to_string(getpid());
+  {
+    std::ofstream out = std::ofstream(tmp_path, std::ios::binary);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(tokens.offsets()),
+              n * sizeof(uint32_t));
+    out.write(reinterpret_cast<const char *>(tokens.lengths()),
+              n * sizeof(uint32_t));
+    out.write(reinterpret_cast<const char *>(values.data()),
+              n * sizeof(token_value_t));
+    out.write(reinterpret_cast<const char *>(first_use.data()),
+              first_use.size() * sizeof(uint32_t));
+    out.write(reinterpret_cast<const char *>(tokens.kinds()), n);
+    out.close();
+    if (!out) {
+      std::remove(tmp_path.c_str());
+      return false;
+    }
+  }
+
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+} // namespace compiler::lexer
@@ -0,0 +1,34 @@
+#include "line_index.h"
+#include "lexer/scan_kernels.h"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+namespace compiler {
+
+line_index_t::line_index_t(std::string_view source) {
+  if (source.length() >= UINT32_MAX) {
+    throw std::runtime_error("Source is too large to index");
+  }
+
+  const lexer::scan_kernels_t &kernels = lexer::scan_kernels();
+  const char *begin = source.data();
+  const char *end = begin + source.length();
+
+  // a line starts one byte after every line feed, so the feeds are collected
+  // with a base of 1
+  this->_line_starts.resize(kernels.count_newlines(begin, end) + 1);
+  this->_line_starts[0] = 0;
+  kernels.find_newlines(begin, end, 1, this->_line_starts.data() + 1);
+}
+
+source_location_t line_index_t::locate(uint32_t offset) const {
+  // the first line start behind offset ends the line that holds it
+  std::vector<uint32_t>::const_iterator next = std::upper_bound(
+      this->_line_starts.begin(), this->_line_starts.end(), offset);
+  uint32_t line = static_cast<uint32_t>(next - this->_line_starts.begin());
+  return source_location_t{line, offset - this->_line_starts[line - 1] + 1};
+}
+
+} // namespace compiler
@@ -1,21 +1,40 @@
 #include "argparse/argparse.hpp"
 #include "code_generation/codegen_visitor.h"
 #include "code_generation/print_test_visitor.h"
+#include "diagnostics.h"
+#include "exceptions.h"
+#include "interner.h"
 #include "lexer/lexer.h"
+#include "line_index.h"
 #include "parser/abstract_syntax_tree.h"
 #include "parser/parser.h"
+#include "source_buffer.h"
+#include "source_stream.h"
 #include "spdlog/spdlog.h"
+#include "thread_pool.h"
+#include "token_buffer.h"
 #include "tokens.h"
+#include <cstdint>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <unistd.h>
 #include <vector>
 
 using namespace compiler;
 
+// a token takes about four bytes of source, so a file this large has enough
+// tokens for parse_tokens to parse it in parallel; lex_file goes parallel
+// from parallel_lex_threshold bytes on
+constexpr size_t parallel_source_threshold =
+    4 * parser::parallel_parse_threshold;
+
 void setup_spdlog() { spdlog::set_level(spdlog::level::debug); }
 
 void setup_argpars(int argc, char *argv[], argparse::ArgumentParser *program) {
@@ -25,11 +44,12 @@ void setup_argpars(int argc, char *argv[], argparse::ArgumentParser *program) {
       .add_epilog("Examples:\n"
                   "  lang program.lang --emit-llvm -o output.ll\n"
                   "  lang program.lang --emit-tokens --emit-ast\n"
+                  "  lang program.lang --emit-outline\n"
                   "  lang program.lang --emit-llvm > output.ll");
 
   (*program)
       .add_argument("source_files")
-      .help("source files to compile")
+      .help("source files to compile, - reads from stdin")
       .remaining();
 
   (*program)
@@ -44,6 +64,12 @@ void setup_argpars(int argc, char *argv[], argparse::ArgumentParser *program) {
       .default_value(false)
       .implicit_value(true);
 
+  (*program)
+      .add_argument("--emit-outline")
+      .help("emit the signatures of the definitions, skipping their bodies")
+      .default_value(false)
+      .implicit_value(true);
+
   (*program)
       .add_argument("--emit-llvm")
       .help("emit LLVM IR")
@@ -55,6 +81,11 @@ void setup_argpars(int argc, char *argv[], argparse::ArgumentParser *program) {
       .help("output file (default: stdout)")
       .default_value(std::string(""));
 
+  (*program)
+      .add_argument("--token-cache")
+      .help("directory to cache token streams of unchanged files in")
+      .default_value(std::string(""));
+
   (*program)
       .add_argument("--print-source")
       .help("print source code before compilation")
@@ -86,26 +117,29 @@ void setup_argpars(int argc, char *argv[], argparse::ArgumentParser *program) {
   // If no emit flags are set, default to emit-llvm
   bool emit_tokens = (*program).get<bool>("--emit-tokens");
   bool emit_ast = (*program).get<bool>("--emit-ast");
+  bool emit_outline = (*program).get<bool>("--emit-outline");
   bool emit_llvm = (*program).get<bool>("--emit-llvm");
 
-  if (!emit_tokens && !emit_ast && !emit_llvm) {
+  if (!emit_tokens && !emit_ast && !emit_outline && !emit_llvm) {
     spdlog::debug("No emit flags specified, defaulting to --emit-llvm");
     // Note: We can't modify the parsed args, so we'll handle this in
     // run_compiler
   }
 }
 
-void debug_print_tokens(std::vector<token_t *> tokens, std::ostream &out) {
-  int current_linenumber = 1;
+void debug_print_tokens(const token_buffer_t &tokens, std::ostream &out) {
+  line_index_t lines = line_index_t(tokens.source());
+  uint32_t current_linenumber = 1;
 
   out << current_linenumber << ":\t";
-  for (token_t *tok : tokens) {
-    if (current_linenumber != tok->linenumber) {
+  for (token_index_t i = 0; i < tokens.size(); i++) {
+    uint32_t linenumber = lines.locate(tokens.offset(i)).line;
+    if (current_linenumber != linenumber) {
       out << std::endl;
-      current_linenumber = tok->linenumber;
+      current_linenumber = linenumber;
       out << current_linenumber << ":\t";
     }
-    std::string s = debug_tok(tok);
+    std::string s = debug_tok(tokens.get(i));
     out << s << " ";
   }
   out << std::endl;
@@ -116,24 +150,100 @@ void debug_print_ast(parser::ast::abstract_syntax_tree_t *program_tree,
   out << program_tree->debug_print() << std::endl;
 }
 
-void print_source(std::string t_source_path, std::ostream &out) {
-  FILE *tp_file = fopen(t_source_path.c_str(), "rb");
-  if (tp_file == NULL) {
-    throw std::runtime_error("Failed to open file: " + t_source_path);
+// prints one line per definition; the body of a function is not needed, so
+// one from parser::parse_declarations is never parsed
+void print_outline(parser::ast::abstract_syntax_tree_t *program_tree,
+                   std::ostream &out) {
+  if (auto *p_func = dynamic_cast<parser::ast::node::function_t *>(
+          program_tree->p_head)) {
+    std::string parameters;
+    for (const std::tuple<token_e, int> &parameter :
+         *p_func->parameter_type_pointer_level_tuple) {
+      if (!parameters.empty()) {
+        parameters += ", ";
+      }
+      parameters += token_t(std::get<0>(parameter), "", 0).type_name();
+      parameters += std::string(std::get<1>(parameter), '*');
+    }
+    out << token_t(p_func->type, "", 0).type_name()
+        << std::string(p_func->pointer_level, '*') << " "
+        << interner_t::global().spelling(p_func->identifier) << "("
+        << parameters << ")" << std::endl;
+  } else if (auto *p_var = dynamic_cast<parser::ast::node::variable_t *>(
+                 program_tree->p_head)) {
+    out << token_t(p_var->type, "", 0).type_name()
+        << std::string(p_var->pointer_level, '*') << " "
+        << interner_t::global().spelling(p_var->identifier) << std::endl;
   }
+}
 
-  // get file size
-  fseek(tp_file, 0, SEEK_END);
-  long file_size = ftell(tp_file);
-  fseek(tp_file, 0, SEEK_SET);
+void print_source(const source_buffer_t &source, std::ostream &out) {
+  out << source.view();
+}
 
-  // allocate buffer and read file
-  std::string source;
-  source.resize(file_size);
-  fread(&source[0], 1, file_size, tp_file);
-  fclose(tp_file);
+// logs the errors of the lexer and the parser at once, in the order they
+// appear in the source, and stops if there were any; without a source they
+// can only be located by byte offset
+void report_diagnostics(const std::string &source_path,
+                        const source_buffer_t *p_source,
+                        const diagnostics_t &lexed,
+                        const diagnostics_t &parsed) {
+  if (lexed.empty() && parsed.empty()) {
+    return;
+  }
 
-  out << source;
+  diagnostics_t diagnostics = diagnostics_t(lexed.limit() + parsed.limit());
+  diagnostics.merge(lexed);
+  diagnostics.merge(parsed);
+  diagnostics.sort();
+
+  if (p_source == nullptr) {
+    for (const diagnostic_t &diagnostic : diagnostics.entries()) {
+      spdlog::error("{}: offset:{}: {}", source_path, diagnostic.offset,
+                    diagnostic.message);
+    }
+  } else {
+    line_index_t lines = line_index_t(p_source->view());
+    for (const diagnostic_t &diagnostic : diagnostics.entries()) {
+      source_location_t loc = lines.locate(diagnostic.offset);
+      std::string_view text =
+          p_source->view().substr(diagnostic.offset, diagnostic.length);
+      spdlog::error("{}: line:{}:{}: {}: {}", source_path, loc.line,
+                    loc.column, text, diagnostic.message);
+    }
+  }
+  if (diagnostics.dropped() > 0) {
+    spdlog::error("{}: {} more errors", source_path, diagnostics.dropped());
+  }
+  exit(1);
+}
+
+// adds an error the parser could not recover from to the others, one that
+// is not tied to a token is placed at the start of the source
+void record_error(const exceptions::syntax_error &err,
+                  diagnostics_t *p_diagnostics) {
+  if (!err.token()) {
+    p_diagnostics->report(0, 0, err.message());
+    return;
+  }
+  const token_t &tok = *err.token();
+  p_diagnostics->report(tok.offset, static_cast<uint32_t>(tok.t_val.length()),
+                        err.message());
+}
+
+// parses stdin while the program writing it may still be running
+std::vector<parser::ast::abstract_syntax_tree_t *> *parse_stdin() {
+  source_stream_t stream = source_stream_t(STDIN_FILENO);
+  lexer::lexer_t lxr = lexer::lexer_t(stream);
+  std::vector<parser::ast::abstract_syntax_tree_t *> *trees = nullptr;
+  diagnostics_t parse_diagnostics = diagnostics_t();
+  try {
+    trees = parser::parse_stream(lxr, &parse_diagnostics);
+  } catch (exceptions::syntax_error &err) {
+    record_error(err, &parse_diagnostics);
+  }
+  report_diagnostics("-", nullptr, lxr.diagnostics(), parse_diagnostics);
+  return trees;
 }
 
 void run_compiler(std::vector<std::string> source_files,
@@ -141,13 +251,15 @@ void run_compiler(std::vector<std::string> source_files,
   // Get command-line options
   bool emit_tokens = program.get<bool>("--emit-tokens");
   bool emit_ast = program.get<bool>("--emit-ast");
+  bool emit_outline = program.get<bool>("--emit-outline");
   bool emit_llvm = program.get<bool>("--emit-llvm");
   bool print_src = program.get<bool>("--print-source");
   bool verbose = program.get<bool>("--verbose");
   std::string output_file = program.get<std::string>("--output");
+  std::string token_cache_dir = program.get<std::string>("--token-cache");
 
   // Default to emit-llvm if nothing specified
-  if (!emit_tokens && !emit_ast && !emit_llvm) {
+  if (!emit_tokens && !emit_ast && !emit_outline && !emit_llvm) {
     emit_llvm = true;
   }
 
@@ -165,31 +277,83 @@ void run_compiler(std::vector<std::string> source_files,
     spdlog::info("Writing output to: {}", output_file);
   }
 
+  std::unique_ptr<lexer::token_cache_t> p_token_cache;
+  if (!token_cache_dir.empty()) {
+    p_token_cache = std::make_unique<lexer::token_cache_t>(token_cache_dir);
+  }
+
   // start compiling
   for (std::string source_path : source_files) {
-    if (print_src) {
-      if (verbose)
-        *out << "========== SOURCE ==========" << std::endl;
-      print_source(source_path, *out);
-      if (verbose)
-        *out << std::endl;
-    }
+    // trees from parser::parse_declarations parse their bodies from these
+    // tokens, which point into the source, so both outlive the trees
+    std::unique_ptr<source_buffer_t> p_source;
+    token_buffer_t tokens;
+    std::vector<parser::ast::abstract_syntax_tree_t *> *trees = nullptr;
+    if (source_path == "-" && !print_src && !emit_tokens && !emit_outline &&
+        !p_token_cache) {
+      // nothing needs the complete source, compile while it arrives
+      trees = parse_stdin();
+    } else {
+      p_source = std::make_unique<source_buffer_t>(
+          source_path == "-" ? "/dev/stdin" : source_path);
+
+      if (print_src) {
+        if (verbose)
+          *out << "========== SOURCE ==========" << std::endl;
+        print_source(*p_source, *out);
+        if (verbose)
+          *out << std::endl;
+      }
 
-    // tokenize
-    std::vector<token_t *> tokens = lexer::lex_file(source_path);
+      // tokenize and parse
+      diagnostics_t diagnostics = diagnostics_t();
+      diagnostics_t parse_diagnostics = diagnostics_t();
+      lexer::lexer_t lxr = lexer::lexer_t(p_source->view());
+      // a large file is lexed and parsed on the whole pool, streaming it
+      // would run on one core
+      bool whole_file = p_source->size() >= parallel_source_threshold &&
+                        thread_pool_t::shared().size() > 1;
+      try {
+        if (emit_tokens || emit_outline || p_token_cache || whole_file) {
+          tokens =
+              lexer::lex_file(*p_source, &diagnostics, p_token_cache.get());
+
+          if (emit_tokens) {
+            if (verbose)
+              *out << "========== LEXER ==========" << std::endl;
+            debug_print_tokens(tokens, *out);
+            if (verbose)
+              *out << std::endl;
+          }
+
+          if (emit_ast || emit_llvm) {
+            trees = parser::parse_tokens(tokens, &parse_diagnostics);
+          } else {
+            // no function body is read, so none is parsed
+            trees = parser::parse_declarations(tokens);
+          }
+        } else {
+          // nobody needs the whole token stream, lex while parsing
+          trees = parser::parse_stream(lxr, &parse_diagnostics);
+        }
+      } catch (exceptions::syntax_error &err) {
+        record_error(err, &parse_diagnostics);
+      }
+      diagnostics.merge(lxr.diagnostics());
+      report_diagnostics(source_path, p_source.get(), diagnostics,
+                         parse_diagnostics);
+    }
 
-    if (emit_tokens) {
+    if (emit_outline) {
       if (verbose)
-        *out << "========== LEXER ==========" << std::endl;
-      debug_print_tokens(tokens, *out);
+        *out << "========== OUTLINE ==========" << std::endl;
+      for (parser::ast::abstract_syntax_tree_t *tree : *trees) {
+        print_outline(tree, *out);
+      }
       if (verbose)
         *out << std::endl;
     }
 
-    // parse
-    std::vector<parser::ast::abstract_syntax_tree_t *> *trees =
-        parser::parse_tokens(tokens);
-
     if (emit_ast) {
       if (verbose)
         *out << "========== PARSER ==========" << std::endl;
@@ -218,6 +382,12 @@ void run_compiler(std::vector<std::string> source_files,
 
       *out << ir_stream.str();
     }
+
+    // the nodes live in the arena of their tree, freeing a tree is cheap
+    for (parser::ast::abstract_syntax_tree_t *tree : *trees) {
+      delete tree;
+    }
+    delete trees;
   }
 
   if (file_stream.is_open()) {
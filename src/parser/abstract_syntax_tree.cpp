@@ -1,17 +1,21 @@
 #include "parser/abstract_syntax_tree.h"
 #include "code_generation/ast_visitor_interface.h"
+#include "interner.h"
+#include "parser/parser.h"
 #include "spdlog/fmt/bundled/format.h"
+#include "symbol_table.h"
 #include "tokens.h"
 #include <string>
 
 // Helper function to convert variant to string
-std::string variant_to_string(
-    const std::variant<int, float, double, char, char *, std::string> &v) {
+std::string variant_to_string(const compiler::parser::ast::node::literal_t &v) {
   return std::visit(
       [](auto &&arg) -> std::string {
         using T = std::decay_t<decltype(arg)>;
-        if constexpr (std::is_same_v<T, std::string>) {
-          return arg;
+        if constexpr (std::is_same_v<T, std::string_view>) {
+          return std::string(arg);
+        } else if constexpr (std::is_same_v<T, compiler::symbol_id_t>) {
+          return compiler::interner_t::global().spelling(arg);
         } else if constexpr (std::is_same_v<T, char *>) {
           return std::string(arg);
         } else if constexpr (std::is_same_v<T, char>) {
@@ -25,6 +29,10 @@ std::string variant_to_string(
 
 namespace compiler::parser::ast {
 
+abstract_syntax_tree_t::abstract_syntax_tree_t() = default;
+
+abstract_syntax_tree_t::~abstract_syntax_tree_t() = default;
+
 std::string abstract_syntax_tree_t::debug_print() {
   return this->p_head->debug_print();
 }
@@ -35,17 +43,12 @@ if_t::if_t(expression_t *p_expr, statement_t *p_stmt) {
   this->p_expr = p_expr;
   this->p_stmt = p_stmt;
 }
-if_t::~if_t() {
-  free(this->p_expr);
-  free(this->p_stmt);
-}
 std::string if_t::debug_print() const {
   return fmt::format("if({0}, {1})", this->p_expr->debug_print(),
                      this->p_stmt->debug_print());
 }
 
 else_t::else_t(statement_t *p_stmt) { this->p_stmt = p_stmt; }
-else_t::~else_t() { free(this->p_stmt); }
 std::string else_t::debug_print() const {
   return fmt::format("else({0})", this->p_stmt->debug_print());
 }
@@ -54,10 +57,6 @@ while_t::while_t(expression_t *p_expr, statement_t *p_stmt) {
   this->p_expr = p_expr;
   this->p_stmt = p_stmt;
 }
-while_t::~while_t() {
-  free(this->p_expr);
-  free(this->p_stmt);
-}
 std::string while_t::debug_print() const {
   return fmt::format("while({0}, {1})", this->p_expr->debug_print(),
                      this->p_stmt->debug_print());
@@ -70,12 +69,6 @@ for_t::for_t(statement_t *p_first, expression_t *p_expr, statement_t *p_last,
   this->p_last = p_last;
   this->p_block = p_block;
 }
-for_t::~for_t() {
-  delete this->p_first;
-  delete this->p_expr;
-  delete this->p_last;
-  delete this->p_block;
-}
 std::string for_t::debug_print() const {
   return fmt::format("for({0};{1};{2}){3}", this->p_first->debug_print(),
                      this->p_expr->debug_print(), this->p_last->debug_print(),
@@ -86,24 +79,19 @@ do_t::do_t(expression_t *p_expr, statement_t *p_stmt) {
   this->p_expr = p_expr;
   this->p_stmt = p_stmt;
 }
-do_t::~do_t() {
-  free(this->p_expr);
-  free(this->p_stmt);
-}
 std::string do_t::debug_print() const {
   return fmt::format("do({1}, {0};", this->p_expr->debug_print(),
                      this->p_stmt->debug_print());
 }
 
 return_t::return_t(expression_t *p_expr) { this->p_expr = p_expr; }
-return_t::~return_t() { free(this->p_expr); }
 std::string return_t::debug_print() const {
   return fmt::format("return({0})", this->p_expr->debug_print());
 }
 
 function_t::function_t(
-    token_e type, int pointer_level, std::string identifier,
-    std::vector<std::tuple<token_e, int>> *parameter_type_pointer_level_tuple,
+    token_e type, int pointer_level, symbol_id_t identifier,
+    node_list_t<std::tuple<token_e, int>> *parameter_type_pointer_level_tuple,
     block_t *block) {
   this->type = type;
   this->pointer_level = pointer_level;
@@ -111,18 +99,22 @@ function_t::function_t(
   this->parameter_type_pointer_level_tuple = parameter_type_pointer_level_tuple;
   this->block = block;
 }
-function_t::~function_t() {
-  free(this->parameter_type_pointer_level_tuple);
-  free(this->block);
-}
 std::string function_t::debug_print() const {
   return fmt::format("function({}, {}, {}, {})\n",
-                     create_token_t(this->type, "", -1)->type_name(),
-                     this->pointer_level, this->identifier,
-                     this->block->debug_print());
+                     token_t(this->type, "", 0).type_name(),
+                     this->pointer_level,
+                     interner_t::global().spelling(this->identifier),
+                     this->body()->debug_print());
+}
+
+block_t *function_t::body() const {
+  if (this->p_deferred_body != nullptr) {
+    parser::parse_deferred_body(this);
+  }
+  return this->block;
 }
 
-variable_t::variable_t(token_e type, int pointer_level, std::string id,
+variable_t::variable_t(token_e type, int pointer_level, symbol_id_t id,
                        expression_t *p_expr, bool is_const, bool is_static) {
   this->type = type;
   this->pointer_level = pointer_level;
@@ -131,11 +123,11 @@ variable_t::variable_t(token_e type, int pointer_level, std::string id,
   this->is_static = is_static;
   this->is_const = is_const;
 }
-variable_t::~variable_t() { free(this->p_expr); }
 std::string variable_t::debug_print() const {
   return fmt::format("variable({}, {}, {}, {})",
-                     create_token_t(this->type, "", -1)->type_name(),
-                     this->pointer_level, this->identifier,
+                     token_t(this->type, "", 0).type_name(),
+                     this->pointer_level,
+                     interner_t::global().spelling(this->identifier),
                      this->p_expr->debug_print());
 }
 
@@ -143,8 +135,9 @@ std::string assign_expr_t::to_prefix_notation() const {
   std::string s;
 
   s = fmt::format("({} {} {})",
-                  compiler::create_token_t(tok_assign, "", -1)->type_name(),
-                  this->identifier, this->right->to_prefix_notation());
+                  compiler::token_t(tok_assign, "", 0).type_name(),
+                  interner_t::global().spelling(this->identifier),
+                  this->right->to_prefix_notation());
 
   return s;
 }
@@ -156,7 +149,7 @@ std::string binary_expr_t::to_prefix_notation() const {
   std::string s;
 
   s = fmt::format(
-      "({} {} {})", compiler::create_token_t(this->op, "", -1)->type_name(),
+      "({} {} {})", compiler::token_t(this->op, "", 0).type_name(),
       this->left->to_prefix_notation(), this->right->to_prefix_notation());
 
   return s;
@@ -169,7 +162,7 @@ std::string unary_expr_t::to_prefix_notation() const {
   std::string s;
 
   s = fmt::format("({} {})",
-                  compiler::create_token_t(this->op, "", -1)->type_name(),
+                  compiler::token_t(this->op, "", 0).type_name(),
                   this->operand->to_prefix_notation());
 
   return s;
@@ -181,7 +174,7 @@ std::string unary_expr_t::debug_print() const {
 std::string literal_expr_t::to_prefix_notation() const {
   std::string s;
 
-  s = fmt::format("({} {})", create_token_t(this->type, "", -1)->type_name(),
+  s = fmt::format("({} {})", token_t(this->type, "", 0).type_name(),
                   variant_to_string(this->value));
 
   return s;
@@ -193,7 +186,8 @@ std::string literal_expr_t::debug_print() const {
 std::string call_expr_t::to_prefix_notation() const {
   std::string s;
 
-  s = fmt::format("(call {})", this->function_name);
+  s = fmt::format("(call {})",
+                  interner_t::global().spelling(this->function_name));
 
   return s;
 }
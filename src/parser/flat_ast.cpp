@@ -0,0 +1,271 @@
+#include "parser/flat_ast.h"
+#include "code_generation/ast_visitor_interface.h"
+#include "interner.h"
+#include "parser/abstract_syntax_tree.h"
+#include "spdlog/fmt/bundled/format.h"
+#include "tokens.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+namespace compiler::parser {
+
+using namespace compiler::parser::ast::node;
+
+/**
+ * @class flatten_visitor_t
+ * @brief Copies nodes into a flat_ast_t, children before their parent
+ */
+class flatten_visitor_t : public compiler::ast::visitor_t {
+public:
+  explicit flatten_visitor_t(flat_ast_t *p_ast) : _p_ast(p_ast) {}
+
+  /// flattens a subtree and returns the id of its root
+  node_id_t flatten(node_t *p_node) {
+    if (p_node == nullptr) {
+      return no_node;
+    }
+    p_node->accept_visitor(this);
+    return this->_last_id;
+  }
+
+  void visit_if(if_t *t_if) {
+    node_id_t expr = this->flatten(t_if->p_expr);
+    node_id_t stmt = this->flatten(t_if->p_stmt);
+    this->_last_id = this->_p_ast->push_back(node_if, tok_if, expr, stmt);
+  }
+
+  void visit_else(else_t *t_else) {
+    node_id_t stmt = this->flatten(t_else->p_stmt);
+    this->_last_id = this->_p_ast->push_back(node_else, tok_else, stmt, 0);
+  }
+
+  void visit_for(for_t *t_for) {
+    node_id_t children[] = {
+        this->flatten(t_for->p_first), this->flatten(t_for->p_expr),
+        this->flatten(t_for->p_last), this->flatten(t_for->p_block)};
+    uint32_t first = this->push_extra(children, 4);
+    this->_last_id = this->_p_ast->push_back(node_for, tok_for, first, 4);
+  }
+
+  void visit_while(while_t *t_while) {
+    node_id_t expr = this->flatten(t_while->p_expr);
+    node_id_t stmt = this->flatten(t_while->p_stmt);
+    this->_last_id =
+        this->_p_ast->push_back(node_while, tok_while, expr, stmt);
+  }
+
+  void visit_do(do_t *t_do) {
+    node_id_t expr = this->flatten(t_do->p_expr);
+    node_id_t stmt = this->flatten(t_do->p_stmt);
+    this->_last_id = this->_p_ast->push_back(node_do, tok_while, expr, stmt);
+  }
+
+  void visit_return(return_t *t_return) {
+    node_id_t expr = this->flatten(t_return->p_expr);
+    this->_last_id =
+        this->_p_ast->push_back(node_return, tok_return, expr, 0);
+  }
+
+  void visit_function(function_t *t_function) {
+    node_id_t block = this->flatten(t_function->body());
+
+    std::vector<uint32_t> words = {
+        static_cast<uint32_t>(t_function->pointer_level), 0};
+    if (t_function->parameter_type_pointer_level_tuple != nullptr) {
+      for (const std::tuple<token_e, int> &parameter :
+           *t_function->parameter_type_pointer_level_tuple) {
+        words.push_back(std::get<token_e>(parameter));
+        words.push_back(static_cast<uint32_t>(std::get<int>(parameter)));
+      }
+    }
+    words[1] = static_cast<uint32_t>(words.size() / 2 - 1);
+    uint32_t first = this->push_extra(words.data(), words.size());
+
+    this->_last_id =
+        this->_p_ast->push_back(node_function, t_function->type, block, first,
+                                token_value_t{t_function->identifier});
+  }
+
+  void visit_variable(variable_t *t_variable) {
+    node_id_t expr = this->flatten(t_variable->p_expr);
+    this->_last_id = this->_p_ast->push_back(
+        node_variable, t_variable->type, expr,
+        static_cast<uint32_t>(t_variable->pointer_level),
+        token_value_t{t_variable->identifier});
+  }
+
+  void visit_assign_expr(assign_expr_t *t_assign_expr) {
+    node_id_t expr = this->flatten(t_assign_expr->right);
+    this->_last_id =
+        this->_p_ast->push_back(node_assign, tok_assign, expr, 0,
+                                token_value_t{t_assign_expr->identifier});
+  }
+
+  void visit_unary_expr(unary_expr_t *t_unary_expr) {
+    node_id_t operand = this->flatten(t_unary_expr->operand);
+    this->_last_id =
+        this->_p_ast->push_back(node_unary, t_unary_expr->op, operand, 0);
+  }
+
+  void visit_call_expr(call_expr_t *t_call_expr) {
+    std::vector<node_id_t> arguments;
+    arguments.reserve(t_call_expr->arguments.size());
+    for (expression_t *p_argument : t_call_expr->arguments) {
+      arguments.push_back(this->flatten(p_argument));
+    }
+    uint32_t first = this->push_extra(arguments.data(), arguments.size());
+    this->_last_id = this->_p_ast->push_back(
+        node_call, tok_lparen, first, static_cast<uint32_t>(arguments.size()),
+        token_value_t{t_call_expr->function_name});
+  }
+
+  void visit_subscript_expr(subscript_expr_t *t_subscript_expr) {
+    node_id_t array = this->flatten(t_subscript_expr->array);
+    node_id_t index = this->flatten(t_subscript_expr->index);
+    this->_last_id =
+        this->_p_ast->push_back(node_subscript, tok_lbracket, array, index);
+  }
+
+  void visit_binary_expr(binary_expr_t *t_binary_expr) {
+    node_id_t left = this->flatten(t_binary_expr->left);
+    node_id_t right = this->flatten(t_binary_expr->right);
+    this->_last_id =
+        this->_p_ast->push_back(node_binary, t_binary_expr->op, left, right);
+  }
+
+  void visit_literal_expr(literal_expr_t *t_literal_expr) {
+    token_value_t value = std::visit(
+        [this](auto &&arg) -> token_value_t {
+          using T = std::decay_t<decltype(arg)>;
+          token_value_t v;
+          if constexpr (std::is_same_v<T, symbol_id_t>) {
+            v.symbol = arg;
+          } else if constexpr (std::is_same_v<T, float> ||
+                               std::is_same_v<T, double>) {
+            v.real = static_cast<float>(arg);
+          } else if constexpr (std::is_same_v<T, std::string_view> ||
+                               std::is_same_v<T, char *>) {
+            v.integer = static_cast<int32_t>(this->_p_ast->_strings.size());
+            this->_p_ast->_strings.emplace_back(arg);
+          } else {
+            v.integer = static_cast<int32_t>(arg);
+          }
+          return v;
+        },
+        t_literal_expr->value);
+    this->_last_id = this->_p_ast->push_back(node_literal, t_literal_expr->type,
+                                             no_node, no_node, value);
+  }
+
+  void visit_block(block_t *t_block) {
+    std::vector<node_id_t> statements;
+    statements.reserve(t_block->statements.size());
+    for (statement_t *p_statement : t_block->statements) {
+      statements.push_back(this->flatten(p_statement));
+    }
+    uint32_t first = this->push_extra(statements.data(), statements.size());
+    this->_last_id = this->_p_ast->push_back(
+        node_block, tok_lbrace, first,
+        static_cast<uint32_t>(statements.size()));
+  }
+
+private:
+  uint32_t push_extra(const uint32_t *p_words, size_t count) {
+    std::vector<uint32_t> &extra = this->_p_ast->_extra;
+    uint32_t first = static_cast<uint32_t>(extra.size());
+    extra.insert(extra.end(), p_words, p_words + count);
+    return first;
+  }
+
+  flat_ast_t *_p_ast;
+  node_id_t _last_id = no_node;
+};
+
+node_id_t flat_ast_t::append(const ast::abstract_syntax_tree_t &tree) {
+  return this->append(tree.p_head);
+}
+
+node_id_t flat_ast_t::append(ast::node::node_t *p_node) {
+  flatten_visitor_t visitor = flatten_visitor_t(this);
+  node_id_t root = visitor.flatten(p_node);
+  if (root != no_node) {
+    this->_roots.push_back(root);
+  }
+  return root;
+}
+
+node_id_t flat_ast_t::push_back(flat_node_e kind, token_e tag, node_id_t lhs,
+                                node_id_t rhs, token_value_t value) {
+  _kinds.push_back(kind);
+  _tags.push_back(static_cast<uint8_t>(tag));
+  _lhs.push_back(lhs);
+  _rhs.push_back(rhs);
+  _values.push_back(value);
+  return static_cast<node_id_t>(_kinds.size() - 1);
+}
+
+std::string flat_ast_t::to_prefix_notation(node_id_t id) const {
+  std::string name = token_t(this->tag(id), "", 0).type_name();
+  token_value_t value = this->value(id);
+
+  switch (this->kind(id)) {
+  case node_binary:
+    return fmt::format("({} {} {})", name, this->to_prefix_notation(_lhs[id]),
+                       this->to_prefix_notation(_rhs[id]));
+  case node_unary:
+    return fmt::format("({} {})", name, this->to_prefix_notation(_lhs[id]));
+  case node_subscript:
+    return fmt::format("({}[{}])", this->to_prefix_notation(_lhs[id]),
+                       this->to_prefix_notation(_rhs[id]));
+  case node_call:
+    return fmt::format("(call {})",
+                       interner_t::global().spelling(value.symbol));
+  case node_assign:
+    return fmt::format("({} {} {})", name,
+                       interner_t::global().spelling(value.symbol),
+                       this->to_prefix_notation(_lhs[id]));
+  case node_literal:
+    // the parser picks the literal_t alternative by token kind
+    switch (this->tag(id)) {
+    case tok_number:
+      return fmt::format("({} {})", name, std::to_string(value.integer));
+    case tok_float_literal:
+      return fmt::format("({} {})", name, std::to_string(value.real));
+    case tok_char_literal:
+      return fmt::format("({} {})", name,
+                         std::string(1, static_cast<char>(value.integer)));
+    case tok_id:
+      return fmt::format("({} {})", name,
+                         interner_t::global().spelling(value.symbol));
+    default:
+      return fmt::format("({} {})", name, _strings[value.integer]);
+    }
+  case node_function:
+  case node_variable:
+  case node_block:
+  case node_if:
+  case node_else:
+  case node_for:
+  case node_while:
+  case node_do:
+  case node_return:
+    break;
+  }
+  return "";
+}
+
+size_t flat_ast_t::memory_usage() const {
+  return _kinds.size() * sizeof(uint8_t) + _tags.size() * sizeof(uint8_t) +
+         _lhs.size() * sizeof(node_id_t) + _rhs.size() * sizeof(node_id_t) +
+         _values.size() * sizeof(token_value_t) +
+         _extra.size() * sizeof(uint32_t) +
+         _strings.size() * sizeof(std::string) +
+         _roots.size() * sizeof(node_id_t);
+}
+
+} // namespace compiler::parser
@@ -1,12 +1,21 @@
 #include "parser/parser.h"
+#include "arena.h"
+#include "diagnostics.h"
 #include "exceptions.h"
+#include "interner.h"
 #include "parser/abstract_syntax_tree.h"
 #include "parser/pratt_parser.h"
+#include "parser/token_cursor.h"
 #include "spdlog/fmt/bundled/format.h"
 #include "symbol_table.h"
+#include "thread_pool.h"
+#include "token_buffer.h"
 #include "tokens.h"
 #include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -17,32 +26,118 @@
 
 namespace compiler::parser {
 
-static symbol_table::symbol_table_t *g_symbol_table = nullptr;
+// per thread, parse_parallel parses several functions at once
+static thread_local symbol_table::symbol_table_t *g_symbol_table = nullptr;
+// arena of the tree being parsed, every node is created in it
+static thread_local arena_t *g_p_arena = nullptr;
+// collects the errors to recover from, nullptr throws the first one
+static thread_local diagnostics_t *g_p_diagnostics = nullptr;
+
+ast::node::block_t *parse_block(token_cursor_t &tokens);
+
+/**
+ * @brief Adds an error to g_p_diagnostics
+ *
+ * Errors without a token are reported at the current token.
+ */
+void report(const exceptions::syntax_error &err, token_cursor_t &tokens) {
+  token_t tok = err.token() ? *err.token() : tokens.peek();
+  g_p_diagnostics->report(tok.offset,
+                          static_cast<uint32_t>(tok.t_val.length()),
+                          err.message());
+}
+
+/**
+ * @brief Closes the scopes a failed parse left open
+ * @param p_scope Scope that was current before, it stays open
+ */
+void unwind_scopes(symbol_table::symbol_table_t *p_scope) {
+  while (g_symbol_table != p_scope) {
+    symbol_table::symbol_table_t *p_inner = g_symbol_table;
+    g_symbol_table = p_inner->p_previous;
+    delete p_inner;
+  }
+}
+
+/**
+ * @brief Skips the rest of a broken statement
+ *
+ * Stops after the next ; or after a nested block, or before the } that
+ * closes the current block.
+ */
+void synchronize_statement(token_cursor_t &tokens) {
+  size_t depth = 0;
+  while (tokens.peek_kind() != tok_eof) {
+    token_e kind = tokens.peek_kind();
+    if (kind == tok_rbrace) {
+      if (depth == 0) {
+        return;
+      }
+      depth--;
+    } else if (kind == tok_lbrace) {
+      depth++;
+    }
+    tokens.advance();
 
-ast::node::block_t *parse_block(std::vector<token_t *> &tokens);
+    if (depth == 0 && (kind == tok_semicolon || kind == tok_rbrace)) {
+      return;
+    }
+  }
+}
+
+/**
+ * @brief Skips to the next top level definition
+ * @param start Position the broken definition started at
+ *
+ * Stops outside of braces, at least one token past start, where a type and
+ * an identifier are followed by (, = or ; as at the start of a definition.
+ * A parameter is followed by , or ) instead.
+ */
+void synchronize_program(token_cursor_t &tokens, size_t start) {
+  size_t depth = 0;
+  while (tokens.peek_kind() != tok_eof) {
+    token_e kind = tokens.peek_kind();
+    token_e after = tokens.peek_kind(2);
+    if (depth == 0 && tokens.position() != start &&
+        tokens.peek_kind(1) == tok_id &&
+        (after == tok_lparen || after == tok_assign ||
+         after == tok_semicolon)) {
+      switch (kind) {
+      case tok_int:
+      case tok_float:
+      case tok_bool:
+      case tok_void:
+      case tok_char:
+        return;
+      default:
+        break;
+      }
+    }
 
-token_t *peek(std::vector<token_t *> &tokens, size_t n = 1) {
-  assert(tokens.size() >= n + 1);
-  return tokens.at(tokens.size() - n);
+    if (kind == tok_lbrace) {
+      depth++;
+    } else if (kind == tok_rbrace && depth > 0) {
+      depth--;
+    }
+    tokens.advance();
+  }
 }
 
-void match(std::vector<token_t *> &tokens, token_e type) {
-  token_t *tok = tokens.back();
-  if (tok->e_tok_type != type) {
+void match(token_cursor_t &tokens, token_e type) {
+  if (tokens.peek_kind() != type) {
     throw exceptions::parser_error(
         fmt::format("Token type didn't match to type {}",
-                    token_t(type, "", -1).type_name()),
-        tok);
+                    token_t(type, "", 0).type_name()),
+        tokens.peek());
   }
-  tokens.pop_back();
+  tokens.advance();
 }
 
-token_e match_type(std::vector<token_t *> &tokens) {
+token_e match_type(token_cursor_t &tokens) {
   token_e type;
-  // DEBUG(debug_tok(peek(tokens)));
+  // DEBUG(debug_tok(tokens.peek()));
 
-  token_t *tok = peek(tokens);
-  type = tok->e_tok_type;
+  type = tokens.peek_kind();
 
   switch (type) {
   case tok_int:
@@ -81,77 +176,77 @@ token_e match_type(std::vector<token_t *> &tokens) {
   case tok_colon:
   case tok_id:
   case tok_number:
+  case tok_float_literal:
   case tok_string:
   case tok_char_literal:
-    throw exceptions::parser_error("not an valid type", peek(tokens));
+  case tok_error:
+    throw exceptions::parser_error("not an valid type", tokens.peek());
   }
 
-  tokens.pop_back();
+  tokens.advance();
   return type;
 }
 
-ast::node::expression_t *parse_expression(std::vector<token_t *> &tokens) {
+ast::node::expression_t *parse_expression(token_cursor_t &tokens) {
   ast::node::expression_t *p_expr =
-      pratt_parser::parse_expression(tokens, g_symbol_table);
+      pratt_parser::parse_expression(tokens, g_symbol_table, g_p_arena);
 
   return p_expr;
 }
 
-ast::node::variable_t *parse_define(std::vector<token_t *> &tokens) {
+ast::node::variable_t *parse_define(token_cursor_t &tokens) {
   ast::node::variable_t *p_var = nullptr;
 
   token_e type;
   int pl = 0;
-  std::string id;
+  symbol_id_t id;
   ast::node::expression_t *expr = nullptr;
 
   // match type
   type = match_type(tokens);
   // match n stars for pointer_level
-  while (tokens.back()->e_tok_type == tok_star) {
+  while (tokens.peek_kind() == tok_star) {
     pl++;
-    tokens.pop_back();
+    tokens.advance();
   }
   // match id
-  token_t *tok = tokens.back();
-  tokens.pop_back();
-  if (tok->e_tok_type != tok_id) {
+  token_t tok = tokens.advance();
+  if (tok.e_tok_type != tok_id) {
     throw exceptions::parser_error("Expected identifier", tok);
   }
-  id = tok->t_val;
+  id = tok.value.symbol;
   // if =
-  if (peek(tokens)->e_tok_type == tok_assign) {
+  if (tokens.peek_kind() == tok_assign) {
     // match =
     match(tokens, tok_assign);
     // match expr
     expr = parse_expression(tokens);
   }
 
-  p_var = new ast::node::variable_t(type, pl, id, expr);
+  p_var = g_p_arena->create<ast::node::variable_t>(type, pl, id, expr);
   g_symbol_table->add(p_var);
 
   return p_var;
 }
 
-ast::node::assign_expr_t *parse_assign(std::vector<token_t *> &tokens) {
+ast::node::assign_expr_t *parse_assign(token_cursor_t &tokens) {
   ast::node::assign_expr_t *assign = nullptr;
 
-  std::string id;
+  symbol_id_t id;
   ast::node::expression_t *expr = nullptr;
 
   // match id
-  token_t *tok = tokens.back();
-  tokens.pop_back();
-  if (tok->e_tok_type != tok_id) {
+  token_t tok = tokens.advance();
+  if (tok.e_tok_type != tok_id) {
     throw exceptions::parser_error("Expected identifier", tok);
   }
-  id = tok->t_val;
+  id = tok.value.symbol;
   if (!g_symbol_table->is_defined(id)) {
     throw exceptions::variable_not_declared_error("variable is not defined",
                                                   tok);
   }
   // if =
-  if (peek(tokens)->e_tok_type == tok_assign) {
+  if (tokens.peek_kind() == tok_assign) {
     // match =
     match(tokens, tok_assign);
     // match expr
@@ -164,30 +259,38 @@ ast::node::assign_expr_t *parse_assign(std::vector<token_t *> &tokens) {
   (void)pl;
   // TODO: make sure the id is already in the simbol table
 
-  assign = new ast::node::assign_expr_t(id, expr);
+  assign = g_p_arena->create<ast::node::assign_expr_t>(id, expr);
 
   return assign;
 }
 
-ast::node::statement_t *parse_statement(std::vector<token_t *> &tokens) {
+ast::node::statement_t *parse_statement(token_cursor_t &tokens) {
   ast::node::statement_t *p_stmt = nullptr;
-  (void)tokens;
 
-  token_t *tok = tokens.back();
-  tokens.pop_back();
+  // keywords are consumed here, definitions and assignments by their parsers
+  token_e kind = tokens.peek_kind();
+  if (kind == tok_if || kind == tok_else || kind == tok_while ||
+      kind == tok_for || kind == tok_return) {
+    tokens.advance();
+  }
 
-  switch (tok->e_tok_type) {
-  case tok_if:
+  switch (kind) {
+  case tok_if: {
+    // the order arguments are evaluated in is unspecified
+    ast::node::expression_t *p_expr = parse_expression(tokens);
     p_stmt =
-        new ast::node::if_t(parse_expression(tokens), parse_statement(tokens));
+        g_p_arena->create<ast::node::if_t>(p_expr, parse_statement(tokens));
     break;
+  }
   case tok_else:
-    p_stmt = new ast::node::else_t(parse_statement(tokens));
+    p_stmt = g_p_arena->create<ast::node::else_t>(parse_statement(tokens));
     break;
-  case tok_while:
-    p_stmt = new ast::node::while_t(parse_expression(tokens),
-                                    parse_statement(tokens));
+  case tok_while: {
+    ast::node::expression_t *p_expr = parse_expression(tokens);
+    p_stmt =
+        g_p_arena->create<ast::node::while_t>(p_expr, parse_statement(tokens));
     break;
+  }
   // case tok_do:
   //   p_stmt =
   //       new ast::node::do_t(parse_expression(tokens),
@@ -208,14 +311,14 @@ ast::node::statement_t *parse_statement(std::vector<token_t *> &tokens) {
     // stmt
     ast::node::block_t *p_block = parse_block(tokens);
 
-    p_stmt = new ast::node::for_t(p_first, p_expr, p_last, p_block);
+    p_stmt =
+        g_p_arena->create<ast::node::for_t>(p_first, p_expr, p_last, p_block);
     break;
   }
   case tok_return:
-    p_stmt = new ast::node::return_t(parse_expression(tokens));
+    p_stmt = g_p_arena->create<ast::node::return_t>(parse_expression(tokens));
     break;
   case tok_id:
-    tokens.push_back(tok);
     p_stmt = parse_assign(tokens);
     break;
   case tok_int:
@@ -223,7 +326,6 @@ ast::node::statement_t *parse_statement(std::vector<token_t *> &tokens) {
   case tok_char:
   case tok_void:
   case tok_bool:
-    tokens.push_back(tok);
     p_stmt = parse_define(tokens);
     break;
   case tok_eof:
@@ -250,24 +352,39 @@ ast::node::statement_t *parse_statement(std::vector<token_t *> &tokens) {
   case tok_semicolon:
   case tok_colon:
   case tok_number:
+  case tok_float_literal:
   case tok_string:
   case tok_char_literal:
-    throw compiler::exceptions::syntax_error("No statement found", tok);
+  case tok_error:
+    // left for synchronize_statement, which skips a whole nested block
+    throw compiler::exceptions::syntax_error("No statement found",
+                                             tokens.peek());
   }
 
   return p_stmt;
 }
 
-ast::node::block_t *parse_block(std::vector<token_t *> &tokens) {
-  ast::node::block_t *p_block = new ast::node::block_t();
+ast::node::block_t *parse_block(token_cursor_t &tokens) {
+  ast::node::block_t *p_block = g_p_arena->create<ast::node::block_t>();
   g_symbol_table = new symbol_table::symbol_table_t(g_symbol_table);
 
   // match {
   match(tokens, tok_lbrace);
   // match stmts
-  while (tokens.back()->e_tok_type != tok_rbrace) {
-    ast::node::statement_t *stmt = parse_statement(tokens);
-    p_block->statements.push_back(stmt);
+  while (tokens.peek_kind() != tok_rbrace) {
+    symbol_table::symbol_table_t *p_scope = g_symbol_table;
+    try {
+      ast::node::statement_t *stmt = parse_statement(tokens);
+      p_block->statements.push_back(*g_p_arena, stmt);
+    } catch (exceptions::syntax_error &err) {
+      // at eof the block is cut off, which the top level reports
+      if (g_p_diagnostics == nullptr || tokens.peek_kind() == tok_eof) {
+        throw;
+      }
+      report(err, tokens);
+      unwind_scopes(p_scope);
+      synchronize_statement(tokens);
+    }
   }
   // match }
   match(tokens, tok_rbrace);
@@ -275,54 +392,58 @@ ast::node::block_t *parse_block(std::vector<token_t *> &tokens) {
   // restore symbol_table
   symbol_table::symbol_table_t *function_symbol_table = g_symbol_table;
   g_symbol_table = g_symbol_table->p_previous;
-  free(function_symbol_table);
+  delete function_symbol_table;
 
   return p_block;
 }
 
-ast::node::function_t *parse_function(std::vector<token_t *> &tokens) {
+/**
+ * @brief Parses a function up to its body
+ *
+ * Leaves the scope of the parameters in g_symbol_table, the function itself
+ * is added to the scope around it.
+ */
+ast::node::function_t *parse_function_head(token_cursor_t &tokens) {
   g_symbol_table = new symbol_table::symbol_table_t(g_symbol_table);
   ast::node::function_t *p_func = nullptr;
 
   token_e type;
   int pointer_level = 0;
-  std::string id;
-  std::vector<std::tuple<token_e, int>> *parameter_type_pointer_level_tuple =
-      new std::vector<std::tuple<token_e, int>>;
-  ast::node::block_t *block = nullptr;
+  symbol_id_t id;
+  ast::node::node_list_t<std::tuple<token_e, int>>
+      *parameter_type_pointer_level_tuple =
+          g_p_arena
+              ->create<ast::node::node_list_t<std::tuple<token_e, int>>>();
 
   // match type
   type = match_type(tokens);
 
   // match pl
-  while (tokens.back()->e_tok_type == tok_star) {
+  while (tokens.peek_kind() == tok_star) {
     pointer_level++;
-    tokens.pop_back();
+    tokens.advance();
   }
 
   // match id
-  token_t *tok = tokens.back();
-  if (tok->e_tok_type != tok_id) {
-    throw exceptions::parser_error("Expected identifier", tok);
+  if (tokens.peek_kind() != tok_id) {
+    throw exceptions::parser_error("Expected identifier", tokens.peek());
   }
-  id = tok->t_val;
-  match(tokens, tok_id);
+  id = tokens.advance().value.symbol;
 
   // match (
   match(tokens, tok_lparen);
 
   // match defines
-  tok = tokens.back();
-  while (tok->e_tok_type != tok_rparen) {
+  while (tokens.peek_kind() != tok_rparen) {
     ast::node::variable_t *param = parse_define(tokens);
     // TODO: add has_default_value
     parameter_type_pointer_level_tuple->push_back(
+        *g_p_arena,
         std::tuple<token_e, int>{param->type, param->pointer_level});
 
-    if (peek(tokens)->e_tok_type == tok_comma) {
-      tokens.pop_back();
+    if (tokens.peek_kind() == tok_comma) {
+      tokens.advance();
     }
-    tok = tokens.back();
   }
 
   // match )
@@ -330,33 +451,35 @@ ast::node::function_t *parse_function(std::vector<token_t *> &tokens) {
 
   // add func to old symbol_table so it is accassible outside
   // add func here to symbol_table so it is accessible inside the block
-  p_func = new ast::node::function_t(
+  p_func = g_p_arena->create<ast::node::function_t>(
       type, pointer_level, id, parameter_type_pointer_level_tuple, nullptr);
   g_symbol_table->p_previous->add(p_func);
 
-  // match block
-  block = parse_block(tokens);
+  return p_func;
+}
 
-  // build full func
-  p_func->block = block;
+ast::node::function_t *parse_function(token_cursor_t &tokens) {
+  ast::node::function_t *p_func = parse_function_head(tokens);
+
+  // match block
+  p_func->block = parse_block(tokens);
 
   // restore symbol_table
   symbol_table::symbol_table_t *function_symbol_table = g_symbol_table;
   g_symbol_table = g_symbol_table->p_previous;
-  free(function_symbol_table);
+  delete function_symbol_table;
 
   return p_func;
 }
 
-ast::node::node_t *parse_program(std::vector<token_t *> &tokens) {
-  if (tokens.size() == 1 && tokens.back()->e_tok_type == tok_eof) {
+ast::node::node_t *parse_program(token_cursor_t &tokens) {
+  if (tokens.peek_kind() == tok_eof) {
     return nullptr;
   }
 
   ast::node::node_t *p_node = nullptr;
 
-  token_t *tok = peek(tokens);
-  switch (tok->e_tok_type) {
+  switch (tokens.peek_kind()) {
   // type
   // case tok_short:
   case tok_int:
@@ -367,10 +490,10 @@ ast::node::node_t *parse_program(std::vector<token_t *> &tokens) {
   case tok_bool:
   case tok_void:
   case tok_char:
-    if (peek(tokens, 2)->e_tok_type != tok_id) {
-      throw exceptions::parser_error("missing identifier after", tok);
+    if (tokens.peek_kind(1) != tok_id) {
+      throw exceptions::parser_error("missing identifier after", tokens.peek());
     }
-    if (peek(tokens, 3)->e_tok_type == tok_lparen) {
+    if (tokens.peek_kind(2) == tok_lparen) {
       p_node = parse_function(tokens);
       g_symbol_table->add(p_node);
     } else {
@@ -407,54 +530,318 @@ ast::node::node_t *parse_program(std::vector<token_t *> &tokens) {
   case tok_colon:
   case tok_id:
   case tok_number:
+  case tok_float_literal:
   case tok_string:
   case tok_char_literal:
-    throw compiler::exceptions::syntax_error("No statement found", tok);
+  case tok_error:
+    throw compiler::exceptions::syntax_error("No statement found",
+                                             tokens.peek());
   }
 
   return p_node;
 }
 
+/**
+ * @brief Parses top level definitions until the cursor reaches tok_eof
+ * @param p_diagnostics Collects the errors and parsing goes on after them,
+ * if nullptr the first error is thrown
+ *
+ * A definition with an error is left out of the returned trees. The errors
+ * inside a block are skipped up to the next ; or }, the others up to the
+ * next top level definition.
+ */
 std::vector<ast::abstract_syntax_tree_t *> *
-parse_tokens(std::vector<token_t *> &tokens) {
-  assert(tokens.size() > 0);
-
+parse_cursor(token_cursor_t &tokens, diagnostics_t *p_diagnostics) {
   std::vector<ast::abstract_syntax_tree_t *> *asts =
       new std::vector<ast::abstract_syntax_tree_t *>();
 
   int i = 0;
-  size_t old_token_len = tokens.size();
-  std::reverse(tokens.begin(), tokens.end());
-  g_symbol_table = new symbol_table::symbol_table_t();
+  size_t old_position = tokens.position();
+  std::unique_ptr<symbol_table::symbol_table_t> p_globals =
+      std::make_unique<symbol_table::symbol_table_t>();
+  g_symbol_table = p_globals.get();
+  g_p_diagnostics = p_diagnostics;
 
-  while (tokens.size() > 1 && i < 100) {
+  while (tokens.peek_kind() != tok_eof && i < 100) {
     ast::abstract_syntax_tree_t *tree = new ast::abstract_syntax_tree_t();
+    size_t start = tokens.position();
+
+    g_p_arena = &tree->arena;
+    try {
+      tree->p_head = parse_program(tokens);
+      asts->push_back(tree);
+    } catch (exceptions::syntax_error &err) {
+      delete tree;
+      unwind_scopes(p_globals.get());
+      if (p_diagnostics == nullptr) {
+        g_symbol_table = nullptr;
+        g_p_arena = nullptr;
+        throw;
+      }
+      report(err, tokens);
+      synchronize_program(tokens, start);
+    }
 
-    tree->p_head = parse_program(tokens);
-    asts->push_back(tree);
-
-    if (old_token_len == tokens.size()) {
+    if (old_position == tokens.position()) {
       i++;
     } else {
-      old_token_len = tokens.size();
+      old_position = tokens.position();
       i = 0;
     }
   }
 
+  g_p_diagnostics = nullptr;
+
   if (i > 1) {
-    if (tokens.size() > 0) {
-      throw exceptions::parser_error("parser runns infinitly long",
-                                     tokens.back());
+    throw exceptions::parser_error("parser runns infinitly long",
+                                   tokens.peek());
+  }
+
+  g_symbol_table = nullptr;
+  g_p_arena = nullptr;
+
+  return asts;
+}
+
+/**
+ * @struct top_level_range_t
+ * @brief Tokens of one top level definition, found by scan_top_level
+ */
+struct top_level_range_t {
+  size_t first;
+  // index of the { opening a function body, SIZE_MAX for a global variable
+  size_t body;
+  size_t end;
+};
+
+/**
+ * @brief Splits a token stream into its top level definitions
+ * @return false if the braces do not match or a definition is cut off
+ *
+ * A definition ends at its first ; unless a { comes first, then it is a
+ * function and ends after the matching }.
+ */
+bool scan_top_level(const token_buffer_t &tokens,
+                    std::vector<top_level_range_t> *p_ranges) {
+  size_t i = 0;
+  while (tokens.kind(i) != tok_eof) {
+    top_level_range_t range = {i, SIZE_MAX, 0};
+    while (tokens.kind(i) != tok_semicolon && tokens.kind(i) != tok_lbrace) {
+      if (tokens.kind(i) == tok_eof || tokens.kind(i) == tok_rbrace) {
+        return false;
+      }
+      i++;
+    }
+
+    if (tokens.kind(i) == tok_lbrace) {
+      range.body = i;
+      size_t depth = 0;
+      do {
+        switch (tokens.kind(i)) {
+        case tok_lbrace:
+          depth++;
+          break;
+        case tok_rbrace:
+          depth--;
+          break;
+        case tok_eof:
+          return false;
+        default:
+          break;
+        }
+        i++;
+      } while (depth > 0);
+    } else {
+      i++;
+    }
+
+    range.end = i;
+    p_ranges->push_back(range);
+  }
+  return true;
+}
+
+/**
+ * @brief Parses the globals and function signatures, deferring the bodies
+ * @throws Whatever error it runs into, not necessarily the first in source
+ *
+ * Trees are added to asts as they are created, so the caller can delete them
+ * after an error. Every function tree keeps the scopes to parse its body in.
+ */
+void parse_heads(const token_buffer_t &token_buffer,
+                 const std::vector<top_level_range_t> &ranges,
+                 std::vector<ast::abstract_syntax_tree_t *> *asts) {
+  std::shared_ptr<symbol_table::symbol_table_t> p_globals =
+      std::make_shared<symbol_table::symbol_table_t>();
+
+  // in order, so every definition is known before the bodies need it
+  for (size_t i = 0; i < ranges.size(); i++) {
+    ast::abstract_syntax_tree_t *tree = new ast::abstract_syntax_tree_t();
+    asts->push_back(tree);
+
+    token_cursor_t tokens = token_cursor_t(token_buffer, ranges[i].first);
+    g_symbol_table = p_globals.get();
+    g_p_arena = &tree->arena;
+
+    symbol_id_t id;
+    if (ranges[i].body == SIZE_MAX) {
+      ast::node::node_t *p_node = parse_program(tokens);
+      if (tokens.position() != ranges[i].end) {
+        throw exceptions::parser_error("Definition ends unexpectedly",
+                                       tokens.peek());
+      }
+      tree->p_head = p_node;
+      id = static_cast<ast::node::variable_t *>(p_node)->identifier;
     } else {
-      throw exceptions::parser_error(
-          "parser runns infinitly long without a token");
+      if (tokens.peek_kind(1) != tok_id || tokens.peek_kind(2) != tok_lparen) {
+        throw exceptions::parser_error("Expected a function", tokens.peek());
+      }
+      ast::node::function_t *p_func = parse_function_head(tokens);
+      tree->p_scope.reset(g_symbol_table);
+      tree->p_globals = p_globals;
+      if (tokens.position() != ranges[i].body) {
+        throw exceptions::parser_error("Expected a function body",
+                                       tokens.peek());
+      }
+
+      // the body only sees the definitions up to its own
+      tree->p_scope->max_declaration_index = i;
+      p_func->p_deferred_body = tree->arena.create<ast::node::deferred_body_t>(
+          ast::node::deferred_body_t{&token_buffer, ranges[i].body,
+                                     ranges[i].end, tree->p_scope.get(),
+                                     &tree->arena});
+      tree->p_head = p_func;
+      id = p_func->identifier;
     }
+    p_globals->table[id]->declaration_index = i;
   }
 
-  free(g_symbol_table);
   g_symbol_table = nullptr;
+  g_p_arena = nullptr;
+}
 
-  return asts;
+void parse_deferred_body(const ast::node::function_t *p_func) {
+  ast::node::deferred_body_t *p_body = p_func->p_deferred_body;
+  assert(p_body != nullptr);
+
+  token_cursor_t tokens = token_cursor_t(*p_body->p_tokens, p_body->first);
+  symbol_table::symbol_table_t *p_scope = p_body->p_scope;
+  g_symbol_table = p_scope;
+  g_p_arena = p_body->p_arena;
+
+  ast::node::block_t *p_block = nullptr;
+  try {
+    p_block = parse_block(tokens);
+  } catch (...) {
+    // the scope of the parameters belongs to the tree, the others are closed
+    unwind_scopes(p_scope);
+    g_symbol_table = nullptr;
+    g_p_arena = nullptr;
+    throw;
+  }
+
+  g_symbol_table = nullptr;
+  g_p_arena = nullptr;
+  if (tokens.position() != p_body->end) {
+    throw exceptions::parser_error("Function ends unexpectedly",
+                                   tokens.peek());
+  }
+  p_func->block = p_block;
+  p_func->p_deferred_body = nullptr;
+}
+
+/**
+ * @brief Frees the trees of a parse that failed
+ */
+void delete_trees(std::vector<ast::abstract_syntax_tree_t *> *asts) {
+  for (ast::abstract_syntax_tree_t *tree : *asts) {
+    delete tree;
+  }
+  delete asts;
+  g_symbol_table = nullptr;
+  g_p_arena = nullptr;
+}
+
+std::vector<ast::abstract_syntax_tree_t *> *
+parse_parallel(const token_buffer_t &token_buffer, thread_pool_t &pool,
+               diagnostics_t *p_diagnostics) {
+  assert(token_buffer.size() > 0);
+
+  std::vector<top_level_range_t> ranges;
+  if (scan_top_level(token_buffer, &ranges)) {
+    std::vector<ast::abstract_syntax_tree_t *> *asts =
+        new std::vector<ast::abstract_syntax_tree_t *>();
+    try {
+      parse_heads(token_buffer, ranges, asts);
+
+      // every body writes only to its own tree and scopes
+      pool.parallel_for(asts->size(), [&](size_t i) {
+        if (ranges[i].body != SIZE_MAX) {
+          static_cast<ast::node::function_t *>((*asts)[i]->p_head)->body();
+        }
+      });
+
+      for (ast::abstract_syntax_tree_t *tree : *asts) {
+        tree->p_scope.reset();
+        tree->p_globals.reset();
+      }
+      return asts;
+    } catch (exceptions::syntax_error &) {
+      // the sequential parse reports the errors in source order
+      delete_trees(asts);
+    } catch (...) {
+      // anything else is a bug or out of memory, not a parse error
+      delete_trees(asts);
+      throw;
+    }
+  }
+
+  token_cursor_t tokens = token_cursor_t(token_buffer);
+  return parse_cursor(tokens, p_diagnostics);
+}
+
+std::vector<ast::abstract_syntax_tree_t *> *
+parse_declarations(const token_buffer_t &token_buffer) {
+  assert(token_buffer.size() > 0);
+
+  std::vector<top_level_range_t> ranges;
+  if (scan_top_level(token_buffer, &ranges)) {
+    std::vector<ast::abstract_syntax_tree_t *> *asts =
+        new std::vector<ast::abstract_syntax_tree_t *>();
+    try {
+      parse_heads(token_buffer, ranges, asts);
+      return asts;
+    } catch (exceptions::syntax_error &) {
+      // the sequential parse reports the first error in the source
+      delete_trees(asts);
+    } catch (...) {
+      delete_trees(asts);
+      throw;
+    }
+  }
+
+  token_cursor_t tokens = token_cursor_t(token_buffer);
+  return parse_cursor(tokens, nullptr);
+}
+
+std::vector<ast::abstract_syntax_tree_t *> *
+parse_tokens(const token_buffer_t &token_buffer,
+             diagnostics_t *p_diagnostics) {
+  assert(token_buffer.size() > 0);
+
+  thread_pool_t &pool = thread_pool_t::shared();
+  if (token_buffer.size() >= parallel_parse_threshold && pool.size() > 1) {
+    return parse_parallel(token_buffer, pool, p_diagnostics);
+  }
+
+  token_cursor_t tokens = token_cursor_t(token_buffer);
+  return parse_cursor(tokens, p_diagnostics);
+}
+
+std::vector<ast::abstract_syntax_tree_t *> *
+parse_stream(lexer::lexer_t &lexer, diagnostics_t *p_diagnostics) {
+  token_cursor_t tokens = token_cursor_t(lexer);
+  return parse_cursor(tokens, p_diagnostics);
 }
 
 } // namespace compiler::parser
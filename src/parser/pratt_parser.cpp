@@ -1,91 +1,84 @@
-// The main pratt parsing part was completly written by claude Sonnet 4.5
-// because my little brain can't plan and write a pratt parser. it failed at
-// laying out the logic in comments.
-// TODO: rewrite this
-
 #include "parser/pratt_parser.h"
+#include "arena.h"
 #include "exceptions.h"
 #include "parser/abstract_syntax_tree.h"
+#include "parser/token_cursor.h"
 #include "symbol_table.h"
 #include "tokens.h"
-#include <cassert>
-#include <cstddef>
-#include <iostream>
-#include <ostream>
-#include <stdexcept>
+#include <array>
+#include <string>
 #include <vector>
 
 namespace compiler {
 namespace parser {
 namespace pratt_parser {
 
-int get_precedence(token_e tok) {
-  switch (tok) {
-
-  case tok_assign:
-    return 0;
-
-    // case OR (||):
-    // return 1;
-
-    // case AND (&&):
-    // return 2;
-
-  case tok_eq:  // ==
-  case tok_neq: // !=
-    return 3;
-
-  case tok_lt:  //
-  case tok_leq: // <=
-  case tok_gt:  // >
-  case tok_geq: // >=
-    return 4;
-
-  case tok_plus:  // +
-  case tok_minus: // -
-    return 5;
-
-  case tok_star:  // *
-  case tok_slash: // /
-                  // case tok_percent: // %
-    return 6;
-
-  case tok_exclaimationmark: // *
-    return 7;
-
-  case tok_lparen: // (
-    return 10;
-  case tok_rparen: // )
-    return 0;
-
-  case tok_eof:
-  case tok_comment:
-  case tok_bool:
-  case tok_char:
-  case tok_int:
-  case tok_float:
-  case tok_void:
-  case tok_if:
-  case tok_else:
-  case tok_while:
-  case tok_for:
-  case tok_return:
-  case tok_lbrace:
-  case tok_rbrace:
-  case tok_lbracket:
-  case tok_rbracket:
-  case tok_comma:
-  case tok_semicolon:
-  case tok_colon:
-  case tok_id:
-  case tok_number:
-  case tok_string:
-  case tok_char_literal:
-    break;
+namespace {
+
+/// Binding powers of an infix operator, {0, 0} for every other token
+struct binding_power_t {
+  int left;
+  int right;
+};
+
+/// Indexed by token_e, the powers are taken from token_spec
+constexpr std::array<binding_power_t, token_kind_count> make_infix_table() {
+  std::array<binding_power_t, token_kind_count> table{};
+  for (token_e op : {tok_assign, tok_eq, tok_neq, tok_lt, tok_leq, tok_gt,
+                     tok_geq, tok_plus, tok_minus, tok_star, tok_slash,
+                     tok_lbracket}) {
+    table[op] = {token_spec[op].left_precidence,
+                 token_spec[op].right_precidence};
   }
-  return -1; // Not an operator
+  return table;
 }
 
+constexpr std::array<binding_power_t, token_kind_count> infix_binding_power =
+    make_infix_table();
+
+/// Prefix !, - and + bind as tightly as !
+constexpr int prefix_binding_power =
+    token_spec[tok_exclaimationmark].right_precidence;
+
+static_assert(prefix_binding_power > infix_binding_power[tok_star].left &&
+                  prefix_binding_power < infix_binding_power[tok_lbracket].left,
+              "unary operators bind tighter than * and looser than []");
+
+/// What an open frame does with the operand parsed for it
+enum class frame_e { root, paren, unary, binary, subscript, call };
+
+/**
+ * An operator, parenthesis or call still waiting for its operand, kept on
+ * an explicit stack instead of the call stack
+ */
+struct frame_t {
+  frame_e kind;
+  ParseContext context;  ///< Context the operand is parsed in
+  int min_binding_power; ///< Operators binding looser end the operand
+  token_e op;
+  ast::node::expression_t *lhs;
+  symbol_id_t callee;
+  ast::node::node_list_t<ast::node::expression_t *> arguments;
+};
+
+frame_t make_frame(frame_e kind, ParseContext context, int min_binding_power,
+                   token_e op = tok_eof,
+                   ast::node::expression_t *lhs = nullptr) {
+  frame_t frame = frame_t();
+  frame.kind = kind;
+  frame.context = context;
+  frame.min_binding_power = min_binding_power;
+  frame.op = op;
+  frame.lhs = lhs;
+  frame.callee = no_symbol;
+  return frame;
+}
+
+/// Reused by every expression parsed on the thread
+thread_local std::vector<frame_t> g_frames;
+
+} // namespace
+
 bool is_expression_delimiter(token_e tok) {
   switch (tok) {
   case tok_semicolon:
@@ -100,324 +93,345 @@ bool is_expression_delimiter(token_e tok) {
   }
 }
 
-token_t *consume(std::vector<token_t *> &tokens) {
-  token_t *tok = tokens.back();
-  tokens.pop_back();
-  return tok;
-}
-
-token_t *peek(std::vector<token_t *> tokens, size_t n = 1) {
-  if (n > tokens.size()) {
-    throw std::range_error("peek out of range");
-  }
-
-  token_t *tok = tokens.at(tokens.size() - n);
-
-  return tok;
+int get_left_binding_power(token_e tok) {
+  return infix_binding_power[tok].left;
 }
 
-void match(std::vector<token_t *> &tokens, token_e type) {
-  if (peek(tokens)->e_tok_type != type) {
+void match(token_cursor_t &tokens, token_e type) {
+  if (tokens.peek_kind() != type) {
     throw exceptions::parser_error("Doesn't match expected token type",
-                                   peek(tokens));
+                                   tokens.peek());
   }
-  tokens.pop_back();
+  tokens.advance();
   return;
 }
 
-int next_op_pressidence(const std::vector<token_t *> &tokens) {
-  token_t *tok;
-
-  for (size_t i = 1; i < tokens.size(); i++) {
-
-    try {
-      tok = peek(tokens, i);
-    } catch (const std::range_error &e) {
-      return 0;
-    }
-
-    // Check if it's an operator
-    switch (tok->e_tok_type) {
-    case tok_plus:
-    case tok_minus:
-    case tok_star:
-    case tok_slash:
-    case tok_lparen:
-      // case tok_percent:
-      return get_precedence(tok->e_tok_type);
-    case tok_eof:
-    case tok_comment:
-    case tok_bool:
-    case tok_char:
-    case tok_int:
-    case tok_float:
-    case tok_void:
-    case tok_if:
-    case tok_else:
-    case tok_while:
-    case tok_for:
-    case tok_return:
-    case tok_assign:
-    case tok_lt:
-    case tok_leq:
-    case tok_gt:
-    case tok_geq:
-    case tok_eq:
-    case tok_neq:
-    case tok_exclaimationmark:
-    case tok_rparen:
-    case tok_lbrace:
-    case tok_rbrace:
-    case tok_lbracket:
-    case tok_rbracket:
-    case tok_comma:
-    case tok_semicolon:
-    case tok_colon:
-    case tok_id:
-    case tok_number:
-    case tok_string:
-    case tok_char_literal:
-      break;
-    }
-  }
-
-  return 0;
-}
-
-// Forward declarations
-ast::node::expression_t *parse_primary(std::vector<token_t *> &tokens,
-                                       ParseContext context);
-
 /**
  * Create binary expression node
  */
 ast::node::expression_t *create_binary_expression(ast::node::expression_t *lhs,
-                                                  token_t *op,
+                                                  token_e op,
                                                   ast::node::expression_t *rhs,
-                                                  ParseContext context) {
+                                                  ParseContext context,
+                                                  arena_t *p_arena) {
   (void)context;
-  return new ast::node::binary_expr_t(lhs, op->e_tok_type, rhs);
+  return p_arena->create<ast::node::binary_expr_t>(lhs, op, rhs);
 }
 
 /**
  * Create unary expression node
  */
 ast::node::expression_t *
-create_unary_expression(token_t *op, ast::node::expression_t *operand,
-                        ParseContext context) {
+create_unary_expression(token_e op, ast::node::expression_t *operand,
+                        ParseContext context, arena_t *p_arena) {
   (void)context;
-  return new ast::node::unary_expr_t(op->e_tok_type, operand);
+  return p_arena->create<ast::node::unary_expr_t>(op, operand);
 }
 
 /**
  * Create literal expression node
  */
-ast::node::expression_t *create_literal_expression(token_t *tok,
-                                                   ParseContext context) {
+ast::node::expression_t *create_literal_expression(const token_t &tok,
+                                                   ParseContext context,
+                                                   arena_t *p_arena) {
   (void)context;
 
-  // Convert string to appropriate type based on token type
-  switch (tok->e_tok_type) {
-  case token_e::tok_number: {
-    // Convert string to int
-    int value = std::stoi(tok->t_val);
-    return new ast::node::literal_expr_t(tok->e_tok_type, value);
-  }
+  // Numbers were decoded by the lexer, the rest is taken from the lexeme
+  switch (tok.e_tok_type) {
+  case token_e::tok_number:
+    return p_arena->create<ast::node::literal_expr_t>(
+        tok.e_tok_type, static_cast<int>(tok.value.integer));
 
-  case token_e::tok_float: {
-    // Convert string to float
-    float value = std::stof(tok->t_val);
-    return new ast::node::literal_expr_t(tok->e_tok_type, value);
-  }
+  case token_e::tok_float_literal:
+    return p_arena->create<ast::node::literal_expr_t>(tok.e_tok_type,
+                                                      tok.value.real);
 
   case token_e::tok_char_literal: {
     // Get the character (assuming it's already parsed correctly)
-    char value = tok->t_val[0];
-    return new ast::node::literal_expr_t(tok->e_tok_type, value);
+    char value = tok.t_val[0];
+    return p_arena->create<ast::node::literal_expr_t>(tok.e_tok_type, value);
   }
 
-  case token_e::tok_string:
   case token_e::tok_id:
+    return p_arena->create<ast::node::literal_expr_t>(tok.e_tok_type,
+                                                      tok.value.symbol);
+
+  case token_e::tok_string:
   default: {
-    // Keep as string for identifiers and string literals
-    return new ast::node::literal_expr_t(tok->e_tok_type, tok->t_val);
+    // Keep as string for string literals, the lexeme may not outlive the
+    // cursor
+    return p_arena->create<ast::node::literal_expr_t>(
+        tok.e_tok_type, p_arena->copy(tok.t_val));
   }
   }
 }
 
 /**
- * Parse primary expressions (atoms and prefix operators)
+ * Whether a token of kind starts an operand that is a single literal or
+ * variable, and the token after it leaves that operand to an operator with
+ * right binding power min_binding_power
  */
-ast::node::expression_t *
-parse_primary(std::vector<token_t *> &tokens, ParseContext context,
-              symbol_table::symbol_table_t *p_symbol_table) {
-  if (tokens.empty()) {
-    throw exceptions::parser_error("Unexpected end of expression");
-  }
-
-  token_t *tok = peek(tokens);
-
-  // Handle parenthesized expressions: (expr)
-  if (tok->e_tok_type == tok_lparen) {
-    consume(tokens); // consume '('
-    ast::node::expression_t *expr =
-        parse_expression(tokens, p_symbol_table, 0, context);
-    // match(tokens, tok_rparen); // consume and verify ')'
-    return expr;
+bool is_atom_operand(token_e kind, token_e next, int min_binding_power) {
+  switch (kind) {
+  case tok_id:
+    if (next == tok_lparen) {
+      return false;
+    }
+    [[fallthrough]];
+  case tok_number:
+  case tok_float_literal:
+  case tok_string:
+  case tok_char_literal:
+    return infix_binding_power[next].left <= min_binding_power;
+  default:
+    return false;
   }
+}
 
-  // Handle prefix unary operators: !, -, +
-  if (tok->e_tok_type == tok_exclaimationmark || tok->e_tok_type == tok_minus ||
-      tok->e_tok_type == tok_plus) {
-    token_t *unary_op = consume(tokens);
-    // Use high precedence for unary operators (they bind tightly)
-    ast::node::expression_t *operand =
-        parse_expression(tokens, p_symbol_table, 60, context);
-    return create_unary_expression(unary_op, operand, context);
+/**
+ * Parse a literal or variable, the kind was checked by is_atom_operand
+ */
+ast::node::expression_t *
+parse_atom(token_cursor_t &tokens, ParseContext context,
+           symbol_table::symbol_table_t *p_symbol_table, arena_t *p_arena) {
+  token_t tok = tokens.advance();
+  if (tok.e_tok_type == tok_id &&
+      !p_symbol_table->is_defined(tok.value.symbol)) {
+    throw exceptions::variable_not_declared_error("identifier is not defined",
+                                                  tok);
   }
+  return create_literal_expression(tok, context, p_arena);
+}
 
-  // Handle literals and identifiers
-  switch (tok->e_tok_type) {
-  case tok_number:
-  case tok_string:
-  case tok_char_literal:
-    return create_literal_expression(consume(tokens), context);
+/**
+ * Parse primary expressions (atoms); prefix operators, parentheses and
+ * calls are opened as frames until an atom is found
+ */
+ast::node::expression_t *
+parse_primary(token_cursor_t &tokens, std::vector<frame_t> &frames,
+              symbol_table::symbol_table_t *p_symbol_table, arena_t *p_arena) {
+  while (true) {
+    ParseContext context = frames.back().context;
+    token_e kind = tokens.peek_kind();
+
+    // Handle parenthesized expressions: (expr)
+    if (kind == tok_lparen) {
+      tokens.advance(); // consume '('
+      frames.push_back(
+          make_frame(frame_e::paren, ParseContext::AFTER_LPAREN, 0));
+      continue;
+    }
 
-  case tok_id: {
-    token_t *id_tok = consume(tokens);
-    if (!p_symbol_table->is_defined(id_tok->t_val)) {
-      throw exceptions::variable_not_declared_error("identifier is not defined",
-                                                    id_tok);
+    // Handle prefix unary operators: !, -, +
+    if (kind == tok_exclaimationmark || kind == tok_minus || kind == tok_plus) {
+      token_e unary_op = tokens.advance().e_tok_type;
+      if (is_atom_operand(tokens.peek_kind(), tokens.peek_kind(1),
+                          prefix_binding_power)) {
+        ast::node::expression_t *operand = parse_atom(
+            tokens, ParseContext::AFTER_OPERATOR, p_symbol_table, p_arena);
+        return create_unary_expression(unary_op, operand, context, p_arena);
+      }
+      frames.push_back(make_frame(frame_e::unary, ParseContext::AFTER_OPERATOR,
+                                  prefix_binding_power, unary_op));
+      continue;
     }
 
-    // Check if it's a function call: identifier(args)
-    if (tokens.size() > 1 && peek(tokens)->e_tok_type == tok_lparen) {
-      consume(tokens); // consume '('
+    // Handle literals and identifiers
+    switch (kind) {
+    case tok_number:
+    case tok_float_literal:
+    case tok_string:
+    case tok_char_literal:
+      return create_literal_expression(tokens.advance(), context, p_arena);
 
-      std::vector<ast::node::expression_t *> arguments;
+    case tok_id: {
+      token_t id_tok = tokens.advance();
+      if (!p_symbol_table->is_defined(id_tok.value.symbol)) {
+        throw exceptions::variable_not_declared_error(
+            "identifier is not defined", id_tok);
+      }
 
-      // Parse arguments
-      while (!tokens.empty() && peek(tokens)->e_tok_type != tok_rparen) {
-        std::cout << debug_tok(tokens.back()) << std::endl;
-        arguments.push_back(
-            parse_expression(tokens, p_symbol_table, 0, context));
-        std::cout << debug_tok(tokens.back()) << std::endl;
+      // Check if it's a function call: identifier(args)
+      if (tokens.peek_kind() == tok_lparen) {
+        tokens.advance(); // consume '('
 
-        // Check for comma (more arguments)
-        if (!tokens.empty() && peek(tokens)->e_tok_type == tok_comma) {
-          consume(tokens); // consume ','
+        // The arguments are collected by the call's frame
+        if (tokens.peek_kind() != tok_eof &&
+            tokens.peek_kind() != tok_rparen) {
+          frames.push_back(make_frame(frame_e::call, ParseContext::START, 0));
+          frames.back().callee = id_tok.value.symbol;
+          continue;
         }
-      }
-
-      match(tokens, tok_rparen); // consume ')'
 
-      // check for ; (end of expression)
-      if (!tokens.empty() && peek(tokens)->e_tok_type == tok_semicolon) {
-        consume(tokens); // consume ';'
+        match(tokens, tok_rparen); // consume ')'
+        return p_arena->create<ast::node::call_expr_t>(
+            id_tok.value.symbol,
+            ast::node::node_list_t<ast::node::expression_t *>());
       }
 
-      return new ast::node::call_expr_t(id_tok->t_val, arguments);
+      // Just an identifier
+      return create_literal_expression(id_tok, context, p_arena);
     }
-
-    // Just an identifier
-    return create_literal_expression(id_tok, context);
-  }
-  case tok_eof:
-  case tok_comment:
-  case tok_bool:
-  case tok_char:
-  case tok_int:
-  case tok_float:
-  case tok_void:
-  case tok_if:
-  case tok_else:
-  case tok_while:
-  case tok_for:
-  case tok_return:
-  case tok_plus:
-  case tok_minus:
-  case tok_star:
-  case tok_slash:
-  case tok_assign:
-  case tok_lt:
-  case tok_leq:
-  case tok_gt:
-  case tok_geq:
-  case tok_eq:
-  case tok_neq:
-  case tok_exclaimationmark:
-  case tok_lparen:
-  case tok_rparen:
-  case tok_lbrace:
-  case tok_rbrace:
-  case tok_lbracket:
-  case tok_rbracket:
-  case tok_comma:
-  case tok_semicolon:
-  case tok_colon:
-    break;
+    case tok_eof:
+    case tok_comment:
+    case tok_bool:
+    case tok_char:
+    case tok_int:
+    case tok_float:
+    case tok_void:
+    case tok_if:
+    case tok_else:
+    case tok_while:
+    case tok_for:
+    case tok_return:
+    case tok_plus:
+    case tok_minus:
+    case tok_star:
+    case tok_slash:
+    case tok_assign:
+    case tok_lt:
+    case tok_leq:
+    case tok_gt:
+    case tok_geq:
+    case tok_eq:
+    case tok_neq:
+    case tok_exclaimationmark:
+    case tok_lparen:
+    case tok_rparen:
+    case tok_lbrace:
+    case tok_rbrace:
+    case tok_lbracket:
+    case tok_rbracket:
+    case tok_comma:
+    case tok_semicolon:
+    case tok_colon:
+    case tok_error:
+      break;
+    }
+    throw exceptions::parser_error("Expected primary expression",
+                                   tokens.peek());
   }
-  throw exceptions::parser_error("Expected primary expression", tok);
 }
 
 /**
- * Main expression parser using Pratt parsing
- * Assumes token vector is REVERSED (last element is first token)
+ * Parse an expression whose operators bind tighter than min_binding_power,
+ * the token that ends it is left on the cursor
+ *
+ * Nesting is tracked in frames on the heap, so the depth of the expression
+ * does not grow the call stack.
  */
 ast::node::expression_t *
-parse_expression(std::vector<token_t *> &tokens,
-                 symbol_table::symbol_table_t *p_symbol_table,
-                 int last_op_precedence, ParseContext context) {
-  // Parse the leftmost operand (primary expression)
-  ast::node::expression_t *lhs = parse_primary(tokens, context, p_symbol_table);
-
-  // Process binary operators with precedence climbing
-  while (!tokens.empty()) {
-    // Peek at the next token
-    token_t *next_tok = peek(tokens);
-
-    // Stop if we hit an expression delimiter or EOF
-    if (is_expression_delimiter(next_tok->e_tok_type) ||
-        next_tok->e_tok_type == tok_eof) {
-      if (peek(tokens, 2)->e_tok_type == tok_semicolon) {
+parse_operand(token_cursor_t &tokens,
+              symbol_table::symbol_table_t *p_symbol_table, arena_t *p_arena,
+              int min_binding_power, ParseContext context) {
+  std::vector<frame_t> &frames = g_frames;
+  frames.clear();
+  frames.push_back(make_frame(frame_e::root, context, min_binding_power));
+
+  while (true) {
+    ast::node::expression_t *operand =
+        parse_primary(tokens, frames, p_symbol_table, p_arena);
+
+    // Fold operators into the operand and close the frames it completes,
+    // until an operator or argument needs the next operand
+    while (true) {
+      frame_t &top = frames.back();
+      token_e op = tokens.peek_kind();
+      binding_power_t power = infix_binding_power[op];
+
+      // An operator binding tighter than the open frame takes the operand,
+      // one with left power 0 is no operator at all
+      if (power.left > top.min_binding_power) {
+        // A right operand that is a single atom, not taken by the operator
+        // after it, is folded in place without opening a frame
+        if (op != tok_lbracket &&
+            is_atom_operand(tokens.peek_kind(1), tokens.peek_kind(2),
+                            power.right)) {
+          tokens.advance();
+          ast::node::expression_t *rhs = parse_atom(
+              tokens, ParseContext::AFTER_OPERATOR, p_symbol_table, p_arena);
+          operand = create_binary_expression(operand, op, rhs, top.context,
+                                             p_arena);
+          continue;
+        }
+
+        tokens.advance();
+        if (op == tok_lbracket) {
+          // Handle array subscript: arr[index]
+          frames.push_back(make_frame(frame_e::subscript, ParseContext::START,
+                                      0, op, operand));
+        } else {
+          // right < left associates to the right (=), right > left to the
+          // left
+          frames.push_back(make_frame(frame_e::binary,
+                                      ParseContext::AFTER_OPERATOR,
+                                      power.right, op, operand));
+        }
         break;
       }
-      consume(tokens);
-      break;
-    }
 
-    // Get the operator's precedence
-    int op_prec = get_precedence(next_tok->e_tok_type);
+      if (top.kind == frame_e::root) {
+        return operand;
+      }
 
-    // If not an operator or precedence is too low, stop
-    if (op_prec < 0 || op_prec < last_op_precedence) {
-      break;
-    }
+      if (top.kind == frame_e::call) {
+        top.arguments.push_back(*p_arena, operand);
 
-    // Handle array subscript: arr[index]
-    if (next_tok->e_tok_type == tok_lbracket) {
-      consume(tokens); // consume '['
-      ast::node::expression_t *index =
-          parse_expression(tokens, p_symbol_table, 0, context);
-      match(tokens, tok_rbracket); // consume ']'
-      lhs = new ast::node::subscript_expr_t(lhs, index);
-      continue;
-    }
-
-    // Consume the binary operator
-    token_t *op = consume(tokens);
+        // Check for comma (more arguments)
+        if (tokens.peek_kind() == tok_comma) {
+          tokens.advance(); // consume ','
+        }
+        if (tokens.peek_kind() != tok_eof &&
+            tokens.peek_kind() != tok_rparen) {
+          break;
+        }
+      }
 
-    // Parse the right-hand side
-    // Use op_prec + 1 for left-associative operators
-    // (ensures operators of same precedence associate left-to-right)
-    ast::node::expression_t *rhs =
-        parse_expression(tokens, p_symbol_table, op_prec + 1, context);
+      const frame_t &frame = top;
+      // the node belongs to the expression around the closed frame
+      ParseContext outer = frames[frames.size() - 2].context;
 
-    // Create binary expression and make it the new lhs
-    lhs = create_binary_expression(lhs, op, rhs, context);
+      switch (frame.kind) {
+      case frame_e::paren:
+        match(tokens, tok_rparen); // consume and verify ')'
+        break;
+      case frame_e::unary:
+        operand = create_unary_expression(frame.op, operand, outer, p_arena);
+        break;
+      case frame_e::binary:
+        operand = create_binary_expression(frame.lhs, frame.op, operand, outer,
+                                           p_arena);
+        break;
+      case frame_e::subscript:
+        match(tokens, tok_rbracket); // consume ']'
+        operand =
+            p_arena->create<ast::node::subscript_expr_t>(frame.lhs, operand);
+        break;
+      case frame_e::call:
+        match(tokens, tok_rparen); // consume ')'
+        operand = p_arena->create<ast::node::call_expr_t>(frame.callee,
+                                                          frame.arguments);
+        break;
+      case frame_e::root:
+        break;
+      }
+      frames.pop_back();
+    }
   }
+}
 
-  return lhs;
+ast::node::expression_t *
+parse_expression(token_cursor_t &tokens,
+                 symbol_table::symbol_table_t *p_symbol_table, arena_t *p_arena,
+                 int min_binding_power, ParseContext context) {
+  ast::node::expression_t *expr = parse_operand(
+      tokens, p_symbol_table, p_arena, min_binding_power, context);
+
+  // The statement parser leaves the terminator to the expression
+  if (is_expression_delimiter(tokens.peek_kind())) {
+    tokens.advance();
+  }
+  return expr;
 }
 
 } // namespace pratt_parser
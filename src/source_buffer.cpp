@@ -0,0 +1,111 @@
+#include "source_buffer.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+namespace compiler {
+
+source_buffer_t::source_buffer_t() {
+  this->_p_data = this->_t_owned.data();
+  this->_size = 0;
+  this->_p_mapping = nullptr;
+}
+
+source_buffer_t::source_buffer_t(const std::string &t_path)
+    : source_buffer_t() {
+  this->_t_path = t_path;
+
+  int fd = open(t_path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Failed to open file: " + t_path);
+  }
+
+  // regular files are mapped, the kernel pages them in while lexing
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    void *p_mapping =
+        mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p_mapping != MAP_FAILED) {
+      madvise(p_mapping, st.st_size, MADV_SEQUENTIAL);
+      close(fd);
+      this->_p_mapping = p_mapping;
+      this->_p_data = static_cast<const char *>(p_mapping);
+      this->_size = st.st_size;
+      return;
+    }
+  }
+
+  // pipes, devices and empty files: read until end of input
+  char chunk[65536];
+  while (true) {
+    ssize_t n = read(fd, chunk, sizeof(chunk));
+    if (n == 0) {
+      break;
+    }
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      close(fd);
+      throw std::runtime_error("Failed to read entire file: " + t_path);
+    }
+    this->_t_owned.append(chunk, n);
+  }
+  close(fd);
+
+  this->_p_data = this->_t_owned.data();
+  this->_size = this->_t_owned.size();
+}
+
+source_buffer_t::source_buffer_t(source_buffer_t &&other) noexcept
+    : source_buffer_t() {
+  *this = std::move(other);
+}
+
+source_buffer_t &source_buffer_t::operator=(source_buffer_t &&other) noexcept {
+  if (this == &other) {
+    return *this;
+  }
+  this->release();
+
+  this->_t_path = std::move(other._t_path);
+  this->_p_mapping = other._p_mapping;
+  this->_size = other._size;
+  if (this->_p_mapping != nullptr) {
+    this->_p_data = other._p_data;
+  } else {
+    this->_t_owned = std::move(other._t_owned);
+    this->_p_data = this->_t_owned.data();
+  }
+
+  other._p_mapping = nullptr;
+  other._t_owned.clear();
+  other._p_data = other._t_owned.data();
+  other._size = 0;
+  return *this;
+}
+
+source_buffer_t::~source_buffer_t() { this->release(); }
+
+source_buffer_t source_buffer_t::from_string(std::string t_source) {
+  source_buffer_t buffer;
+  buffer._t_owned = std::move(t_source);
+  buffer._p_data = buffer._t_owned.data();
+  buffer._size = buffer._t_owned.size();
+  return buffer;
+}
+
+void source_buffer_t::release() {
+  if (this->_p_mapping != nullptr) {
+    munmap(this->_p_mapping, this->_size);
+    this->_p_mapping = nullptr;
+  }
+}
+
+} // namespace compiler
@@ -0,0 +1,39 @@
+#include "source_stream.h"
+#include <cerrno>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+namespace compiler {
+
+source_stream_t::source_stream_t(int fd, size_t chunk_size) {
+  this->_fd = fd;
+  this->_chunk_size = chunk_size > 0 ? chunk_size : default_chunk_size;
+  this->_at_end = false;
+}
+
+size_t source_stream_t::read_chunk(std::string *p_buffer) {
+  if (this->_at_end) {
+    return 0;
+  }
+
+  size_t old_size = p_buffer->size();
+  p_buffer->resize(old_size + this->_chunk_size);
+  while (true) {
+    ssize_t n = read(this->_fd, p_buffer->data() + old_size, this->_chunk_size);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      p_buffer->resize(old_size);
+      throw std::runtime_error("Failed to read source stream");
+    }
+
+    p_buffer->resize(old_size + n);
+    this->_at_end = n == 0;
+    return n;
+  }
+}
+
+} // namespace compiler
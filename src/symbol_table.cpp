@@ -1,6 +1,9 @@
 #include "symbol_table.h"
 #include "exceptions.h"
+#include "interner.h"
 #include "parser/abstract_syntax_tree.h"
+#include <algorithm>
+#include <cstdint>
 
 namespace compiler::symbol_table {
 
@@ -39,15 +42,16 @@ void symbol_table_t::add(parser::ast::node::node_t *p_node) {
   }
 }
 
-bool symbol_table_t::is_defined(std::string id) {
+bool symbol_table_t::is_defined(symbol_id_t id) {
+  size_t max_declaration_index = SIZE_MAX;
   for (symbol_table_t *symtab = this; symtab != nullptr;
        symtab = symtab->p_previous) {
-    for (std::pair<const std::basic_string<char>,
-                   compiler::symbol_table::data_t *>
-             entry : symtab->table) {
-      if (entry.first == id) {
-        return true;
-      }
+    max_declaration_index =
+        std::min(max_declaration_index, symtab->max_declaration_index);
+    auto it = symtab->table.find(id);
+    if (it != symtab->table.end() &&
+        it->second->declaration_index <= max_declaration_index) {
+      return true;
     }
   }
   return false;
@@ -58,7 +62,7 @@ void symbol_table_t::assign(parser::ast::node::assign_expr_t *p_assign) {
     throw exceptions::variable_not_declared_error(
         fmt::format("Variable {} is not defined, thus it's not possible to "
                     "assign something to it",
-                    p_assign->identifier));
+                    interner_t::global().spelling(p_assign->identifier)));
   }
 
   this->table[p_assign->identifier]->set_expr(p_assign->right);
@@ -67,7 +71,7 @@ void symbol_table_t::assign(parser::ast::node::assign_expr_t *p_assign) {
 parser::ast::node::expression_t *data_t::get_expr() { return this->p_expr; }
 
 void data_t::set_expr(parser::ast::node::expression_t *p_expr) {
-  free(this->p_expr);
+  // the old expression stays in the arena of its tree
   this->p_expr = p_expr;
 }
 
@@ -0,0 +1,99 @@
+#include "thread_pool.h"
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace compiler {
+
+thread_pool_t::thread_pool_t(size_t n_threads) {
+  if (n_threads == 0) {
+    n_threads = std::thread::hardware_concurrency();
+  }
+  this->_stopping = false;
+  for (size_t i = 1; i < n_threads; i++) {
+    this->_workers.emplace_back([this]() { this->work(); });
+  }
+}
+
+thread_pool_t::~thread_pool_t() {
+  {
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    this->_stopping = true;
+  }
+  this->_task_ready.notify_all();
+  for (std::thread &worker : this->_workers) {
+    worker.join();
+  }
+}
+
+thread_pool_t &thread_pool_t::shared() {
+  static thread_pool_t pool;
+  return pool;
+}
+
+bool thread_pool_t::run_one(std::unique_lock<std::mutex> &lock) {
+  if (this->_queue.empty()) {
+    return false;
+  }
+  std::function<void()> task = std::move(this->_queue.front());
+  this->_queue.pop_front();
+
+  lock.unlock();
+  task();
+  lock.lock();
+  return true;
+}
+
+void thread_pool_t::work() {
+  std::unique_lock<std::mutex> lock(this->_mutex);
+  while (true) {
+    this->_task_ready.wait(
+        lock, [this]() { return this->_stopping || !this->_queue.empty(); });
+    if (!this->run_one(lock) && this->_stopping) {
+      return;
+    }
+  }
+}
+
+void thread_pool_t::parallel_for(size_t n,
+                                 const std::function<void(size_t)> &task) {
+  size_t remaining = n;
+  std::exception_ptr p_error = nullptr;
+
+  std::unique_lock<std::mutex> lock(this->_mutex);
+  for (size_t i = 0; i < n; i++) {
+    this->_queue.emplace_back([this, i, &task, &remaining, &p_error]() {
+      std::exception_ptr p_task_error = nullptr;
+      try {
+        task(i);
+      } catch (...) {
+        p_task_error = std::current_exception();
+      }
+
+      std::lock_guard<std::mutex> done_lock(this->_mutex);
+      if (p_task_error != nullptr && p_error == nullptr) {
+        p_error = p_task_error;
+      }
+      remaining--;
+      this->_task_done.notify_all();
+    });
+  }
+  this->_task_ready.notify_all();
+
+  // help with the queue instead of idling, then wait for the stragglers
+  while (remaining > 0) {
+    if (!this->run_one(lock)) {
+      this->_task_done.wait(lock);
+    }
+  }
+  lock.unlock();
+
+  if (p_error != nullptr) {
+    std::rethrow_exception(p_error);
+  }
+}
+
+} // namespace compiler
@@ -1,161 +1,47 @@
 #include "tokens.h"
+#include "arena.h"
 #include "spdlog/fmt/bundled/format.h"
 // #include "spdlog/fmt/fmt.h"
 //
 #include <string>
+#include <string_view>
 
 namespace compiler {
 
-token_t::token_t(token_e e_tok_type, std::string t_val, int linenumber) {
+token_t::token_t(token_e e_tok_type, std::string_view t_val, uint32_t offset,
+                 token_value_t value) {
   this->e_tok_type = e_tok_type;
   this->t_val = t_val;
-  this->linenumber = linenumber;
+  this->offset = offset;
+  this->value = value;
 }
 
-std::string token_t::type_name() {
-  switch (this->e_tok_type) {
-  case tok_eof:
-    return "eof";
-  case tok_comment:
-    return "comment";
-  case tok_id:
-    return "id";
-  case tok_number:
-    return "number";
-  case tok_string:
-    return "string";
-  // case tok_let:
-  //   return "let";
-  // case tok_mut:
-  //   return "mut";
-  // case tok_dyn:
-  //   return "dyn";
-  // case tok_static:
-  //   return "static";
-  // case tok_typedef:
-  //   return "typedef";
-  // case tok_short:
-  //   return "short";
-  case tok_int:
-    return "int";
-  // case tok_long:
-  //   return "long";
-  // case tok_long_long:
-  //   return "longlong";
-  case tok_float:
-    return "float";
-  // case tok_double:
-  //   return "double";
-  case tok_char:
-    return "char";
-  case tok_bool:
-    return "bool";
-  case tok_void:
-    return "void";
-  // case tok_enum:
-  //   return "enum";
-  // case tok_struct:
-  //   return "struct";
-  // case tok_union:
-  //   return "union";
-  case tok_if:
-    return "if";
-  case tok_else:
-    return "else";
-  // case tok_switch:
-  //   return "switch";
-  // case tok_case:
-  //   return "case";
-  // case tok_default:
-  //   return "default";
-  // case tok_questionmark:
-  //   return "questionmark";
-  case tok_exclaimationmark:
-    return "exclaimationmark";
-  // case tok_do:
-  //   return "do";
-  case tok_while:
-    return "while";
-  case tok_for:
-    return "for";
-  // case tok_break:
-  //   return "break";
-  // case tok_continue:
-  //   return "continue";
-  case tok_return:
-    return "return";
-  case tok_plus:
-    return "plus";
-  case tok_minus:
-    return "minus";
-  case tok_star:
-    return "star";
-  case tok_slash:
-    return "slash";
-  case tok_char_literal:
-    return "char_literal";
-  // case tok_percent:
-  //   return "percent";
-  case tok_assign:
-    return "assign";
-  case tok_eq:
-    return "eq";
-  case tok_neq:
-    return "neq";
-  case tok_lt:
-    return "lt";
-  case tok_leq:
-    return "leq";
-  case tok_gt:
-    return "gt";
-  case tok_geq:
-    return "geq";
-  case tok_lparen:
-    return "lparen";
-  case tok_rparen:
-    return "rparen";
-  case tok_lbracket:
-    return "lbracket";
-  case tok_rbracket:
-    return "rbracket";
-  case tok_lbrace:
-    return "lbrace";
-  case tok_rbrace:
-    return "rbrace";
-  case tok_semicolon:
-    return "semicolon";
-  case tok_colon:
-    return "colon";
-  case tok_comma:
-    return "comma";
-    // case tok_dot:
-    //   return "dot";
+std::string token_t::type_name() const {
+  if (static_cast<size_t>(this->e_tok_type) >= token_kind_count) {
+    return "TOKEN NOT YET NAMED!!!";
   }
-  return "TOKEN NOT YET NAMED!!!";
+  return std::string(token_spec[this->e_tok_type].name);
 }
 
 int get_left_precidence(token_e tok) {
-  int lh, rh;
-  std::tie(lh, rh) = token_presidence[tok];
-  return lh;
+  return token_spec[tok].left_precidence;
 }
 
 int get_right_precidence(token_e tok) {
-  int lh, rh;
-  std::tie(lh, rh) = token_presidence[tok];
-  return rh;
+  return token_spec[tok].right_precidence;
 }
 
-token_t *create_token_t(token_e e_tok_type, std::string t_val, int linenumber) {
-  token_t *tok;
-  tok = new token_t(e_tok_type, t_val, linenumber);
-  return tok;
+token_t *create_token_t(arena_t &arena, token_e e_tok_type,
+                        std::string_view t_val, uint32_t offset,
+                        token_value_t value) {
+  return arena.create<token_t>(e_tok_type, arena.copy(t_val), offset, value);
 }
 
-std::string debug_tok(token_t *token) {
+std::string debug_tok(token_t *token) { return debug_tok(*token); }
+
+std::string debug_tok(const token_t &token) {
   std::string s;
-  s = fmt::format("<{}, ({})>", token->type_name().c_str(),
-                  token->t_val.c_str());
+  s = fmt::format("<{}, ({})>", token.type_name(), token.t_val);
   return s;
 }
 
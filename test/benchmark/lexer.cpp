@@ -0,0 +1,176 @@
+#include "lexer/lexer.h"
+#include "source_buffer.h"
+#include "token_buffer.h"
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace compiler;
+
+// Throughput of the lexer on synthetic corpora shaped like examples/*.lang.
+// Every corpus repeats a small unit of code, numbered so identifiers stay
+// distinct, until it reaches the requested size. The reported complexity of
+// bench_lex_scaling should come out as O(N) in the number of bytes.
+//
+//   make bench
+//
+// writes the results to build/bench_lexer.json.
+
+namespace {
+
+using corpus_unit_t = std::string (*)(size_t i);
+
+/// declarations and expressions with many distinct, longer names
+std::string identifier_unit(size_t i) {
+  std::string n = std::to_string(i);
+  return "int accumulated_total_" + n + " = previous_value_" + n +
+         " + scale_factor_" + n + " * offset_" + n + ";\n" +
+         "accumulated_total_" + n + " = compute_next(accumulated_total_" + n +
+         ", previous_value_" + n + ");\n";
+}
+
+/// short statements between full line and end of line comments
+std::string comment_unit(size_t i) {
+  std::string n = std::to_string(i);
+  return "// step " + n + ": halve the value before it is returned\n" +
+         "// the result is rounded towards zero like in C\n" +
+         "int result_" + n + " = number / 2; // comment at end of line\n";
+}
+
+/// integer and float literals of different lengths
+std::string number_unit(size_t i) {
+  std::string n = std::to_string(i);
+  return "float f_" + n + " = 3.25 * 1000000 + .5 - " + n + ".125;\n" +
+         "int k_" + n + " = 42 + 7 * 1234567 - " + n + " / 16;\n";
+}
+
+/// a function of deeply nested blocks with wide indentation
+std::string nested_unit(size_t i) {
+  const size_t depth = 12;
+  std::string n = std::to_string(i);
+  std::string unit = "int nested_" + n + "(int a) {\n";
+  for (size_t d = 1; d <= depth; d++) {
+    std::string indent = std::string(2 * d, ' ');
+    unit += indent + (d % 2 == 1 ? "if (a > " : "while (a < ") +
+            std::to_string(d) + ") {\n";
+  }
+  unit += std::string(2 * depth + 2, ' ') + "a = a + 1;\n";
+  for (size_t d = depth; d >= 1; d--) {
+    unit += std::string(2 * d, ' ') + "}\n";
+  }
+  unit += "  return a;\n}\n";
+  return unit;
+}
+
+/// a byte no rule matches on every line, should lex as fast as valid code
+std::string malformed_unit(size_t i) {
+  std::string n = std::to_string(i);
+  return "  int value_" + n + " = value_11 @ 3 + 17;\n";
+}
+
+/// the same two lines over and over, for the scaling benchmark
+std::string scaling_unit(size_t i) {
+  (void)i;
+  return "  int value_12 = value_11 * 3 + 17; // note\n"
+         "  if (value_12 >= 4) { return f(value_12); }\n";
+}
+
+std::string build_corpus(corpus_unit_t unit, size_t size) {
+  std::string source;
+  source.reserve(size + 1024);
+  for (size_t i = 0; source.length() < size; i++) {
+    source += unit(i);
+  }
+  return source;
+}
+
+void report(benchmark::State &state, size_t bytes, size_t tokens) {
+  int64_t iterations = static_cast<int64_t>(state.iterations());
+  state.SetBytesProcessed(iterations * static_cast<int64_t>(bytes));
+  state.counters["tokens_per_second"] =
+      benchmark::Counter(static_cast<double>(iterations) * tokens,
+                         benchmark::Counter::kIsRate);
+  state.counters["tokens"] = static_cast<double>(tokens);
+}
+
+void bench_lex(benchmark::State &state, corpus_unit_t unit) {
+  std::string source = build_corpus(unit, state.range(0));
+  lexer::lexer_t lxr = lexer::lexer_t();
+
+  size_t n_tokens = 0;
+  for (auto _ : state) {
+    token_buffer_t tokens = lxr.lex(source);
+    n_tokens = tokens.size();
+    benchmark::DoNotOptimize(tokens.kinds());
+  }
+  report(state, source.length(), n_tokens);
+}
+
+// time per byte has to stay flat with the input size; a lexer that copies
+// the remaining input per token shows up as O(N^2)
+void bench_lex_scaling(benchmark::State &state) {
+  std::string source = build_corpus(scaling_unit, state.range(0));
+  lexer::lexer_t lxr = lexer::lexer_t();
+
+  for (auto _ : state) {
+    token_buffer_t tokens = lxr.lex(source);
+    benchmark::DoNotOptimize(tokens.kinds());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(source.length()));
+  state.SetComplexityN(static_cast<int64_t>(source.length()));
+}
+
+void bench_lex_file(benchmark::State &state, corpus_unit_t unit) {
+  // lex_file wants a loaded file, loading it is not part of the measurement
+  std::filesystem::path path =
+      std::filesystem::temp_directory_path() /
+      ("bench_lexer_" + std::to_string(state.range(0)) + ".lang");
+  {
+    std::ofstream file = std::ofstream(path, std::ios::binary);
+    file << build_corpus(unit, state.range(0));
+  }
+  source_buffer_t source = source_buffer_t(path.string());
+  std::filesystem::remove(path);
+
+  size_t n_tokens = 0;
+  for (auto _ : state) {
+    token_buffer_t tokens = lexer::lex_file(source);
+    n_tokens = tokens.size();
+    benchmark::DoNotOptimize(tokens.kinds());
+  }
+  report(state, source.size(), n_tokens);
+}
+
+} // namespace
+
+// 1 MiB stays on one thread, 16 MiB is above lexer::parallel_lex_threshold
+#define LEXER_BENCHMARK(corpus)                                                \
+  BENCHMARK_CAPTURE(bench_lex, corpus, corpus##_unit)                          \
+      ->Arg(1 << 20)                                                           \
+      ->Arg(16 << 20)                                                          \
+      ->Unit(benchmark::kMillisecond);                                         \
+  BENCHMARK_CAPTURE(bench_lex_file, corpus, corpus##_unit)                     \
+      ->Arg(1 << 20)                                                           \
+      ->Arg(16 << 20)                                                          \
+      ->Unit(benchmark::kMillisecond)                                          \
+      ->UseRealTime()
+
+LEXER_BENCHMARK(identifier);
+LEXER_BENCHMARK(comment);
+LEXER_BENCHMARK(number);
+LEXER_BENCHMARK(nested);
+LEXER_BENCHMARK(malformed);
+
+// up to 100 MiB, the size of a large generated file
+BENCHMARK(bench_lex_scaling)
+    ->RangeMultiplier(8)
+    ->Range(1 << 10, 64 << 20)
+    ->Arg(100 << 20)
+    ->Unit(benchmark::kMillisecond)
+    ->Complexity(benchmark::oN);
+
+BENCHMARK_MAIN();
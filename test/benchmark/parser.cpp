@@ -0,0 +1,236 @@
+#include "arena.h"
+#include "lexer/lexer.h"
+#include "code_generation/ast_visitor_interface.h"
+#include "parser/abstract_syntax_tree.h"
+#include "parser/flat_ast.h"
+#include "parser/parser.h"
+#include "parser/pratt_parser.h"
+#include "parser/token_cursor.h"
+#include "symbol_table.h"
+#include "thread_pool.h"
+#include "token_buffer.h"
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace compiler;
+
+// Time of the Pratt parser over one expression of growing length. The
+// reported complexity should come out as O(N) in the number of tokens.
+// The same expression is also evaluated once through the pointer tree and
+// once in a linear pass over its flat_ast_t, comparing memory and speed.
+// Whole programs of many small functions are parsed by parse_parallel on a
+// growing number of threads.
+//
+//   make bench
+//
+// writes the results to build/bench_parser.json.
+
+namespace {
+
+/// one long expression with precedence levels, parentheses and prefix minus
+std::string build_expression(size_t n_tokens) {
+  const size_t tokens_per_unit = 12;
+  std::string source = "1";
+  for (size_t i = 0; i * tokens_per_unit < n_tokens; i++) {
+    std::string n = std::to_string(i % 1000);
+    source += " + (" + n + " - 3) * -" + n + " / 7 < 2";
+  }
+  return source + ";";
+}
+
+void bench_parse_expression(benchmark::State &state) {
+  std::string source = build_expression(state.range(0));
+  lexer::lexer_t lxr = lexer::lexer_t();
+  token_buffer_t tokens = lxr.lex(source);
+  symbol_table::symbol_table_t st;
+  arena_t arena;
+
+  for (auto _ : state) {
+    parser::token_cursor_t cursor = parser::token_cursor_t(tokens);
+    parser::ast::node::expression_t *p_expr =
+        parser::pratt_parser::parse_expression(cursor, &st, &arena);
+    benchmark::DoNotOptimize(p_expr);
+    arena.release();
+  }
+
+  int64_t iterations = static_cast<int64_t>(state.iterations());
+  state.SetItemsProcessed(iterations * static_cast<int64_t>(tokens.size()));
+  state.SetComplexityN(static_cast<int64_t>(tokens.size()));
+}
+
+/// wrapping integer arithmetic, the benchmark expression has no other nodes
+uint32_t apply(token_e op, uint32_t lhs, uint32_t rhs) {
+  switch (op) {
+  case tok_plus:
+    return lhs + rhs;
+  case tok_minus:
+    return lhs - rhs;
+  case tok_star:
+    return lhs * rhs;
+  case tok_slash:
+    return rhs == 0 ? 0 : lhs / rhs;
+  case tok_lt:
+    return static_cast<int32_t>(lhs) < static_cast<int32_t>(rhs);
+  default:
+    return 0;
+  }
+}
+
+/// evaluates through the virtual calls and child pointers of the tree
+class evaluate_visitor_t : public ast::visitor_t {
+public:
+  uint32_t result = 0;
+
+  void visit_binary_expr(parser::ast::node::binary_expr_t *t_binary_expr) {
+    t_binary_expr->left->accept_visitor(this);
+    uint32_t left = this->result;
+    t_binary_expr->right->accept_visitor(this);
+    this->result = apply(t_binary_expr->op, left, this->result);
+  }
+  void visit_unary_expr(parser::ast::node::unary_expr_t *t_unary_expr) {
+    t_unary_expr->operand->accept_visitor(this);
+    this->result = apply(t_unary_expr->op, 0, this->result);
+  }
+  void visit_literal_expr(parser::ast::node::literal_expr_t *t_literal_expr) {
+    this->result = static_cast<uint32_t>(std::get<int>(t_literal_expr->value));
+  }
+
+  void visit_if(parser::ast::node::if_t *) {}
+  void visit_else(parser::ast::node::else_t *) {}
+  void visit_for(parser::ast::node::for_t *) {}
+  void visit_while(parser::ast::node::while_t *) {}
+  void visit_do(parser::ast::node::do_t *) {}
+  void visit_return(parser::ast::node::return_t *) {}
+  void visit_function(parser::ast::node::function_t *) {}
+  void visit_variable(parser::ast::node::variable_t *) {}
+  void visit_assign_expr(parser::ast::node::assign_expr_t *) {}
+  void visit_call_expr(parser::ast::node::call_expr_t *) {}
+  void visit_subscript_expr(parser::ast::node::subscript_expr_t *) {}
+  void visit_block(parser::ast::node::block_t *) {}
+};
+
+/// evaluates in one pass over the ids, operands come before their operator
+uint32_t evaluate_flat(const parser::flat_ast_t &ast,
+                       std::vector<uint32_t> &results) {
+  results.resize(ast.size());
+  for (parser::node_id_t id = 0; id < ast.size(); id++) {
+    switch (ast.kind(id)) {
+    case parser::node_literal:
+      results[id] = static_cast<uint32_t>(ast.value(id).integer);
+      break;
+    case parser::node_unary:
+      results[id] = apply(ast.tag(id), 0, results[ast.lhs(id)]);
+      break;
+    case parser::node_binary:
+      results[id] =
+          apply(ast.tag(id), results[ast.lhs(id)], results[ast.rhs(id)]);
+      break;
+    default:
+      results[id] = 0;
+      break;
+    }
+  }
+  return results.back();
+}
+
+parser::ast::node::expression_t *parse(token_buffer_t &tokens,
+                                       arena_t &arena) {
+  parser::token_cursor_t cursor = parser::token_cursor_t(tokens);
+  symbol_table::symbol_table_t st;
+  return parser::pratt_parser::parse_expression(cursor, &st, &arena);
+}
+
+void bench_evaluate_tree(benchmark::State &state) {
+  std::string source = build_expression(state.range(0));
+  lexer::lexer_t lxr = lexer::lexer_t();
+  token_buffer_t tokens = lxr.lex(source);
+  arena_t arena;
+  parser::ast::node::expression_t *p_expr = parse(tokens, arena);
+
+  evaluate_visitor_t visitor;
+  for (auto _ : state) {
+    p_expr->accept_visitor(&visitor);
+    benchmark::DoNotOptimize(visitor.result);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(tokens.size()));
+  state.counters["ast_bytes"] = static_cast<double>(arena.size());
+}
+
+void bench_evaluate_flat(benchmark::State &state) {
+  std::string source = build_expression(state.range(0));
+  lexer::lexer_t lxr = lexer::lexer_t();
+  token_buffer_t tokens = lxr.lex(source);
+  arena_t arena;
+  parser::flat_ast_t ast;
+  ast.append(parse(tokens, arena));
+  arena.release();
+
+  std::vector<uint32_t> results;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(evaluate_flat(ast, results));
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(tokens.size()));
+  state.counters["ast_bytes"] = static_cast<double>(ast.memory_usage());
+}
+
+/// a program of small functions, each calling the one before
+std::string build_program(size_t n_functions) {
+  std::string source = "int f0(int a) { return a; }\n";
+  for (size_t i = 1; i < n_functions; i++) {
+    std::string n = std::to_string(i);
+    source += "int f" + n + "(int a) {\n  int x = a * " + n +
+              " + 1;\n  while (x > 100) x = x / 2;\n  return f" +
+              std::to_string(i - 1) + "(x);\n}\n";
+  }
+  return source;
+}
+
+void bench_parse_program(benchmark::State &state) {
+  std::string source = build_program(4096);
+  lexer::lexer_t lxr = lexer::lexer_t();
+  token_buffer_t tokens = lxr.lex(source);
+  thread_pool_t pool = thread_pool_t(static_cast<size_t>(state.range(0)));
+
+  for (auto _ : state) {
+    std::vector<parser::ast::abstract_syntax_tree_t *> *trees =
+        parser::parse_parallel(tokens, pool);
+    benchmark::DoNotOptimize(trees->data());
+    for (parser::ast::abstract_syntax_tree_t *tree : *trees) {
+      delete tree;
+    }
+    delete trees;
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(tokens.size()));
+}
+
+} // namespace
+
+BENCHMARK(bench_parse_expression)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 1 << 18)
+    ->Unit(benchmark::kMicrosecond)
+    ->Complexity(benchmark::oN);
+
+BENCHMARK(bench_evaluate_tree)
+    ->RangeMultiplier(16)
+    ->Range(1 << 10, 1 << 18)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(bench_evaluate_flat)
+    ->RangeMultiplier(16)
+    ->Range(1 << 10, 1 << 18)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(bench_parse_program)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -1,4 +1,5 @@
 #include "lexer/lexer.h"
+#include "source_buffer.h"
 #include "tokens.h"
 #include <gtest/gtest.h>
 #include <iostream>
@@ -22,8 +23,9 @@ protected:
 
 // Test token creation
 TEST_F(lexer_modul_test, lex_file) {
-  std::vector<token_t *> tokens =
-      lexer::lex_file("../test/moduletest/lexer_test_file.lang");
+  source_buffer_t source =
+      source_buffer_t("../test/moduletest/lexer_test_file.lang");
+  token_buffer_t tokens = lexer::lex_file(source);
 
   std::string expected = "int (int)\n"
                          "id (main)\n"
@@ -76,8 +78,9 @@ TEST_F(lexer_modul_test, lex_file) {
                          "eof ()\n";
 
   std::string token_string;
-  for (token_t *tok : tokens) {
-    token_string = token_string + tok->type_name() + " (" + tok->t_val + ")\n";
+  for (token_index_t i = 0; i < tokens.size(); i++) {
+    token_string = token_string + tokens.get(i).type_name() + " (" +
+                   std::string(tokens.text(i)) + ")\n";
   }
 
   std::cout << token_string << std::endl;
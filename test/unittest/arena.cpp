@@ -0,0 +1,44 @@
+#include "arena.h"
+#include "tokens.h"
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+
+using namespace compiler;
+
+class arena_unit_test : public ::testing::Test {
+protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+TEST_F(arena_unit_test, allocations_are_aligned_and_disjoint) {
+  arena_t arena = arena_t(64);
+  char *p_byte = static_cast<char *>(arena.allocate(1, 1));
+  uint64_t *p_word = arena.create<uint64_t>(42u);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(p_word) % alignof(uint64_t));
+  EXPECT_EQ(42u, *p_word);
+  EXPECT_NE(static_cast<void *>(p_byte), static_cast<void *>(p_word));
+
+  // larger than a block, gets a block of its own
+  char *p_big = static_cast<char *>(arena.allocate(1000, 1));
+  p_big[999] = 'x';
+  EXPECT_EQ(42u, *p_word);
+  EXPECT_EQ(1u + sizeof(uint64_t) + 1000u, arena.size());
+
+  arena.release();
+  EXPECT_EQ(0u, arena.size());
+}
+
+TEST_F(arena_unit_test, tokens_own_their_lexeme) {
+  arena_t arena;
+  token_t *p_tok;
+  {
+    std::string source = "value";
+    p_tok = create_token_t(arena, tok_id, source, 3);
+  }
+  EXPECT_EQ(tok_id, p_tok->e_tok_type);
+  EXPECT_EQ("value", p_tok->t_val);
+  EXPECT_EQ(3u, p_tok->offset);
+}
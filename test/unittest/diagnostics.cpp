@@ -0,0 +1,67 @@
+#include "diagnostics.h"
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace compiler;
+
+class diagnostics_unit_test : public ::testing::Test {
+protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+TEST_F(diagnostics_unit_test, keeps_up_to_the_limit) {
+  diagnostics_t diagnostics = diagnostics_t(2);
+  EXPECT_TRUE(diagnostics.empty());
+
+  diagnostics.report(1, 1, "first");
+  diagnostics.report(5, 2, "second");
+  diagnostics.report(9, 1, "third");
+  diagnostics.report(12, 1, "fourth");
+
+  ASSERT_EQ(2u, diagnostics.entries().size());
+  EXPECT_EQ(1u, diagnostics.entries()[0].offset);
+  EXPECT_EQ("first", diagnostics.entries()[0].message);
+  EXPECT_EQ(5u, diagnostics.entries()[1].offset);
+  EXPECT_EQ(2u, diagnostics.entries()[1].length);
+  EXPECT_EQ(2u, diagnostics.dropped());
+  EXPECT_FALSE(diagnostics.empty());
+
+  diagnostics.clear();
+  EXPECT_TRUE(diagnostics.empty());
+  EXPECT_EQ(0u, diagnostics.dropped());
+}
+
+TEST_F(diagnostics_unit_test, merge_appends_in_order) {
+  diagnostics_t first = diagnostics_t(3);
+  diagnostics_t second = diagnostics_t(3);
+  first.report(1, 1, "a");
+  first.report(2, 1, "b");
+  second.report(10, 1, "c");
+  second.report(11, 1, "d");
+  second.report(12, 1, "e");
+  second.report(13, 1, "f");
+
+  first.merge(second);
+  ASSERT_EQ(3u, first.entries().size());
+  EXPECT_EQ("c", first.entries()[2].message);
+  // d and e no longer fit, f was already dropped by second
+  EXPECT_EQ(3u, first.dropped());
+}
+
+TEST_F(diagnostics_unit_test, sort_orders_by_offset) {
+  diagnostics_t lexed = diagnostics_t();
+  diagnostics_t parsed = diagnostics_t();
+  lexed.report(4, 1, "lexer at 4");
+  lexed.report(20, 1, "lexer at 20");
+  parsed.report(4, 1, "parser at 4");
+  parsed.report(12, 1, "parser at 12");
+
+  lexed.merge(parsed);
+  lexed.sort();
+  ASSERT_EQ(4u, lexed.entries().size());
+  EXPECT_EQ("lexer at 4", lexed.entries()[0].message);
+  EXPECT_EQ("parser at 4", lexed.entries()[1].message);
+  EXPECT_EQ("parser at 12", lexed.entries()[2].message);
+  EXPECT_EQ("lexer at 20", lexed.entries()[3].message);
+}
@@ -1,3 +1,4 @@
+#include "arena.h"
 #include "parser/expression.h"
 #include "tokens.h"
 #include <gtest/gtest.h>
@@ -17,28 +18,31 @@ protected:
 
 TEST_F(expression_unit_test, to_prefix_notation) {
   // Build from innermost to outermost
+  arena_t arena;
 
   // Create the atom for 4
-  auto four_expr = new expression_t(atom_t{create_token_t(tok_number, "4", 1)});
+  auto four_expr =
+      new expression_t(atom_t{create_token_t(arena, tok_number, "4", 1)});
 
   // (-4) : unary minus on 4
   auto unary_neg_4_expr = new expression_t(std::make_unique<unary_expr_t>(
-      create_token_t(tok_minus, "-", 1), four_expr));
+      create_token_t(arena, tok_minus, "-", 1), four_expr));
 
   // Create the atom for 5
-  auto five_expr = new expression_t(atom_t{create_token_t(tok_number, "5", 1)});
+  auto five_expr =
+      new expression_t(atom_t{create_token_t(arena, tok_number, "5", 1)});
 
   // (* (-4) 5) : multiply
   auto mul_expr = new expression_t(std::make_unique<binary_expr_t>(
-      unary_neg_4_expr, create_token_t(tok_star, "*", 1), five_expr));
+      unary_neg_4_expr, create_token_t(arena, tok_star, "*", 1), five_expr));
 
   // Create the atom for 3
   auto three_expr =
-      new expression_t(atom_t{create_token_t(tok_number, "3", 1)});
+      new expression_t(atom_t{create_token_t(arena, tok_number, "3", 1)});
 
   // (+ 3 (* (-4) 5)) : add
   expression_t expression = std::make_unique<binary_expr_t>(
-      three_expr, create_token_t(tok_plus, "+", 1), mul_expr);
+      three_expr, create_token_t(arena, tok_plus, "+", 1), mul_expr);
 
   const auto &binary = std::get<std::unique_ptr<binary_expr_t>>(expression);
   const auto &left = std::get<atom_t>(*binary->left);
@@ -0,0 +1,139 @@
+#include "parser/flat_ast.h"
+#include "arena.h"
+#include "lexer/lexer.h"
+#include "parser/abstract_syntax_tree.h"
+#include "parser/parser.h"
+#include "parser/pratt_parser.h"
+#include "parser/token_cursor.h"
+#include "symbol_table.h"
+#include "token_buffer.h"
+#include "tokens.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using namespace compiler;
+using parser::node_id_t;
+
+class flat_ast_unit_test : public ::testing::Test {
+protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+/// checks that every child id is smaller than its parent's
+static void expect_post_order(const parser::flat_ast_t &ast) {
+  for (node_id_t id = 0; id < ast.size(); id++) {
+    std::vector<node_id_t> children;
+    switch (ast.kind(id)) {
+    case parser::node_block:
+    case parser::node_call:
+      children.assign(ast.extra(ast.lhs(id)),
+                      ast.extra(ast.lhs(id)) + ast.rhs(id));
+      break;
+    case parser::node_for:
+      children.assign(ast.extra(ast.lhs(id)), ast.extra(ast.lhs(id)) + 4);
+      break;
+    case parser::node_function:
+    case parser::node_variable:
+    case parser::node_else:
+    case parser::node_return:
+    case parser::node_assign:
+    case parser::node_unary:
+      children.push_back(ast.lhs(id));
+      break;
+    case parser::node_if:
+    case parser::node_while:
+    case parser::node_do:
+    case parser::node_binary:
+    case parser::node_subscript:
+      children.push_back(ast.lhs(id));
+      children.push_back(ast.rhs(id));
+      break;
+    case parser::node_literal:
+      break;
+    }
+    for (node_id_t child : children) {
+      if (child != parser::no_node) {
+        EXPECT_LT(child, id) << "node " << id;
+      }
+    }
+  }
+}
+
+TEST_F(flat_ast_unit_test, expressions_print_like_the_tree) {
+  std::string source = "-(1 + 2) * 3 < 4.5 - 'c';";
+  lexer::lexer_t lxr;
+  token_buffer_t tokens = lxr.lex(source);
+  parser::token_cursor_t cursor = parser::token_cursor_t(tokens);
+  symbol_table::symbol_table_t st;
+  arena_t arena;
+  parser::ast::node::expression_t *p_expr =
+      parser::pratt_parser::parse_expression(cursor, &st, &arena);
+
+  parser::flat_ast_t ast;
+  node_id_t root = ast.append(p_expr);
+  EXPECT_EQ(ast.size() - 1, root);
+  EXPECT_EQ(p_expr->to_prefix_notation(), ast.to_prefix_notation(root));
+  EXPECT_EQ(parser::node_binary, ast.kind(root));
+  EXPECT_EQ(tok_lt, ast.tag(root));
+  expect_post_order(ast);
+}
+
+TEST_F(flat_ast_unit_test, programs_are_stored_in_post_order) {
+  std::string source = "int half(int number) { return number / 2; }\n"
+                       "int main(int argc, char *argv) {\n"
+                       "  int i = half(5);\n"
+                       "  for (int k = 0; k < i; k = k + 1) {\n"
+                       "    if (k == 2) i = i - 1;\n"
+                       "  }\n"
+                       "  return i;\n"
+                       "}\n";
+  lexer::lexer_t lxr;
+  token_buffer_t tokens = lxr.lex(source);
+  std::vector<parser::ast::abstract_syntax_tree_t *> *p_trees =
+      parser::parse_tokens(tokens);
+
+  parser::flat_ast_t ast;
+  for (parser::ast::abstract_syntax_tree_t *p_tree : *p_trees) {
+    ast.append(*p_tree);
+  }
+  ASSERT_EQ(2u, ast.roots().size());
+  expect_post_order(ast);
+
+  node_id_t main = ast.roots()[1];
+  EXPECT_EQ(parser::node_function, ast.kind(main));
+  EXPECT_EQ("main", interner_t::global().spelling(ast.value(main).symbol));
+  const uint32_t *p_words = ast.extra(ast.rhs(main));
+  EXPECT_EQ(0u, p_words[0]);             // pointer level
+  ASSERT_EQ(2u, p_words[1]);             // parameters
+  EXPECT_EQ(tok_char, p_words[4]);       // type of argv
+  EXPECT_EQ(1u, p_words[5]);             // pointer level of argv
+  node_id_t body = ast.lhs(main);
+  EXPECT_EQ(parser::node_block, ast.kind(body));
+  EXPECT_EQ(3u, ast.rhs(body));
+
+  for (parser::ast::abstract_syntax_tree_t *p_tree : *p_trees) {
+    delete p_tree;
+  }
+  delete p_trees;
+}
+
+TEST_F(flat_ast_unit_test, uses_less_than_half_the_memory) {
+  std::string source = "1";
+  for (int i = 0; i < 2000; i++) {
+    source += " + (" + std::to_string(i) + " - 3) * -7";
+  }
+  source += ";";
+  lexer::lexer_t lxr;
+  token_buffer_t tokens = lxr.lex(source);
+  parser::token_cursor_t cursor = parser::token_cursor_t(tokens);
+  symbol_table::symbol_table_t st;
+  arena_t arena;
+  parser::ast::node::expression_t *p_expr =
+      parser::pratt_parser::parse_expression(cursor, &st, &arena);
+
+  parser::flat_ast_t ast;
+  ast.append(p_expr);
+  EXPECT_LE(2 * ast.memory_usage(), arena.size());
+}
@@ -0,0 +1,47 @@
+#include "interner.h"
+#include "thread_pool.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using namespace compiler;
+
+class interner_unit_test : public ::testing::Test {
+protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+TEST_F(interner_unit_test, same_spelling_same_id) {
+  interner_t interner;
+
+  symbol_id_t a = interner.intern("value");
+  symbol_id_t b = interner.intern("other");
+  EXPECT_EQ(0u, a);
+  EXPECT_EQ(1u, b);
+
+  // the spelling is copied, the caller's storage may go away
+  std::string spelling = "value";
+  EXPECT_EQ(a, interner.intern(spelling));
+  spelling = "changed";
+  EXPECT_EQ("value", interner.spelling(a));
+  EXPECT_EQ("other", interner.spelling(b));
+  EXPECT_EQ(2u, interner.size());
+}
+
+TEST_F(interner_unit_test, concurrent_intern) {
+  interner_t interner;
+  thread_pool_t pool = thread_pool_t(4);
+  std::vector<symbol_id_t> ids(64 * 100);
+
+  pool.parallel_for(64, [&](size_t task) {
+    for (size_t i = 0; i < 100; i++) {
+      ids[task * 100 + i] = interner.intern("name_" + std::to_string(i));
+    }
+  });
+
+  ASSERT_EQ(100u, interner.size());
+  for (size_t i = 0; i < ids.size(); i++) {
+    EXPECT_EQ("name_" + std::to_string(i % 100), interner.spelling(ids[i]));
+  }
+}
@@ -1,9 +1,23 @@
+#include "arena.h"
+#include "diagnostics.h"
+#include "interner.h"
 #include "lexer/lexer.h"
+#include "line_index.h"
+#include "source_stream.h"
+#include "thread_pool.h"
+#include "token_buffer.h"
 #include "tokens.h"
+#include <algorithm>
 #include <gtest/gtest.h>
 #include <iostream>
 #include <ostream>
+#include <random>
+#include <regex>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unistd.h>
 #include <vector>
 
 using namespace compiler;
@@ -28,21 +42,445 @@ protected:
 // test for the case that a return is tokenized as a id
 // (happens when token_e order is wrong)
 TEST_F(lexer_unit_test, lex_return_order) {
+  arena_t arena;
   std::vector<token_t *> expected;
-  expected.push_back(create_token_t(tok_return, "return", 1));
-  expected.push_back(create_token_t(tok_number, "0", 1));
-  expected.push_back(create_token_t(tok_semicolon, ";", 1));
-  expected.push_back(create_token_t(tok_eof, "", 1));
+  expected.push_back(create_token_t(arena, tok_return, "return", 0));
+  expected.push_back(create_token_t(arena, tok_number, "0", 7));
+  expected.push_back(create_token_t(arena, tok_semicolon, ";", 8));
+  expected.push_back(create_token_t(arena, tok_eof, "", 9));
 
-  std::vector<token_t *> tokens = this->tp_lexer->lex("return 0;");
+  std::string source = "return 0;";
+  token_buffer_t tokens = this->tp_lexer->lex(source);
 
   ASSERT_EQ(expected.size(), tokens.size());
-  EXPECT_EQ(expected[0]->e_tok_type, tokens[0]->e_tok_type);
-  EXPECT_EQ(expected[0]->t_val, tokens[0]->t_val);
-  EXPECT_EQ(expected[1]->e_tok_type, tokens[1]->e_tok_type);
-  EXPECT_EQ(expected[1]->t_val, tokens[1]->t_val);
-  EXPECT_EQ(expected[2]->e_tok_type, tokens[2]->e_tok_type);
-  EXPECT_EQ(expected[2]->t_val, tokens[2]->t_val);
-  EXPECT_EQ(expected[3]->e_tok_type, tokens[3]->e_tok_type);
-  EXPECT_EQ(expected[3]->t_val, tokens[3]->t_val);
+  EXPECT_EQ(expected[0]->e_tok_type, tokens.kind(0));
+  EXPECT_EQ(expected[0]->t_val, tokens.text(0));
+  EXPECT_EQ(expected[1]->e_tok_type, tokens.kind(1));
+  EXPECT_EQ(expected[1]->t_val, tokens.text(1));
+  EXPECT_EQ(expected[2]->e_tok_type, tokens.kind(2));
+  EXPECT_EQ(expected[2]->t_val, tokens.text(2));
+  EXPECT_EQ(expected[3]->e_tok_type, tokens.kind(3));
+  EXPECT_EQ(expected[3]->t_val, tokens.text(3));
+}
+
+// reference lexer driven by the token_spec patterns: every rule is tried at the
+// current position and the longest match wins, ties go to the rule declared
+// first in token_e, runs of bytes no rule matches become one tok_error
+std::vector<token_t *> regex_lex(arena_t &arena,
+                                 const std::string &source) {
+  static const std::vector<std::regex> rules = [] {
+    std::vector<std::regex> compiled;
+    for (const token_spec_t &spec : token_spec) {
+      compiled.emplace_back(std::string(spec.pattern));
+    }
+    return compiled;
+  }();
+  std::vector<token_t *> tokens;
+  size_t pos = 0;
+
+  while (pos < source.length()) {
+    char c = source[pos];
+    if (c == ' ' || c == '\t' || c == '\n') {
+      pos++;
+      continue;
+    }
+
+    std::string rest = source.substr(pos);
+    token_e best_kind = tok_eof;
+    size_t best_length = 0;
+    for (size_t kind = 0; kind < token_kind_count; kind++) {
+      std::smatch match;
+      if (std::regex_search(rest, match, rules[kind],
+                            std::regex_constants::match_continuous) &&
+          static_cast<size_t>(match.length(0)) > best_length) {
+        best_kind = static_cast<token_e>(kind);
+        best_length = match.length(0);
+      }
+    }
+
+    if (best_length == 0) {
+      // consecutive bytes no rule matches form one error token
+      if (!tokens.empty() && tokens.back()->e_tok_type == tok_error &&
+          tokens.back()->offset + tokens.back()->t_val.length() == pos) {
+        tokens.back()->t_val = std::string_view(source).substr(
+            tokens.back()->offset, tokens.back()->t_val.length() + 1);
+      } else {
+        tokens.push_back(create_token_t(
+            arena, tok_error, std::string_view(source).substr(pos, 1),
+            static_cast<uint32_t>(pos)));
+      }
+      pos++;
+      continue;
+    }
+    if (best_kind != tok_comment) {
+      tokens.push_back(create_token_t(
+          arena, best_kind, std::string_view(source).substr(pos, best_length),
+          static_cast<uint32_t>(pos)));
+    }
+    pos += best_length;
+  }
+
+  tokens.push_back(create_token_t(arena, tok_eof, "",
+                                  static_cast<uint32_t>(source.length())));
+  return tokens;
+}
+
+void expect_same_tokens(const std::string &source) {
+  lexer::lexer_t lxr;
+  arena_t arena;
+  std::vector<token_t *> expected = regex_lex(arena, source);
+  token_buffer_t tokens = lxr.lex(source);
+
+  ASSERT_EQ(expected.size(), tokens.size()) << source;
+  for (token_index_t i = 0; i < expected.size(); i++) {
+    EXPECT_EQ(expected[i]->e_tok_type, tokens.kind(i))
+        << "token " << i << " in: " << source;
+    EXPECT_EQ(expected[i]->t_val, tokens.text(i))
+        << "token " << i << " in: " << source;
+    EXPECT_EQ(expected[i]->offset, tokens.offset(i))
+        << "token " << i << " in: " << source;
+  }
+
+  // so does lexing in pieces, with cuts after every few lines
+  thread_pool_t pool = thread_pool_t(3);
+  for (size_t n_chunks : {2, 5, 64}) {
+    token_buffer_t parallel = lexer::lex_parallel(source, pool, n_chunks);
+    ASSERT_EQ(tokens.size(), parallel.size()) << source;
+    for (token_index_t i = 0; i < tokens.size(); i++) {
+      EXPECT_EQ(tokens.kind(i), parallel.kind(i)) << "token " << i;
+      EXPECT_EQ(tokens.offset(i), parallel.offset(i)) << "token " << i;
+      EXPECT_EQ(tokens.length(i), parallel.length(i)) << "token " << i;
+      EXPECT_EQ(tokens.symbol(i), parallel.symbol(i)) << "token " << i;
+    }
+  }
+
+  // the streaming interface has to produce the same tokens
+  lexer::lexer_t stream = lexer::lexer_t(source);
+  for (token_index_t i = 0; i < tokens.size(); i++) {
+    token_t tok = stream.next_token();
+    EXPECT_EQ(tokens.kind(i), tok.e_tok_type)
+        << "token " << i << " in: " << source;
+    EXPECT_EQ(tokens.text(i), tok.t_val)
+        << "token " << i << " in: " << source;
+    EXPECT_EQ(tokens.offset(i), tok.offset)
+        << "token " << i << " in: " << source;
+    EXPECT_EQ(tokens.symbol(i), tok.value.symbol)
+        << "token " << i << " in: " << source;
+  }
+}
+
+TEST_F(lexer_unit_test, lex_interns_identifiers) {
+  std::string source = "int value = other;\nvalue = value + 1;";
+  token_buffer_t tokens = this->tp_lexer->lex(source);
+
+  interner_t &interner = interner_t::global();
+  EXPECT_EQ(no_symbol, tokens.symbol(0));
+  EXPECT_EQ(interner.intern("value"), tokens.symbol(1));
+  EXPECT_EQ(interner.intern("other"), tokens.symbol(3));
+  EXPECT_EQ(tokens.symbol(1), tokens.symbol(5));
+  EXPECT_EQ(tokens.symbol(1), tokens.symbol(7));
+  EXPECT_EQ("value", interner.spelling(tokens.get(5).value.symbol));
+  EXPECT_EQ(no_symbol, tokens.symbol(10));
+}
+
+TEST_F(lexer_unit_test, lex_decodes_numbers) {
+  std::string source = "0 42 2147483647 2147483648 1.5 .25 3.0";
+  token_buffer_t tokens = this->tp_lexer->lex(source);
+
+  ASSERT_EQ(8u, tokens.size());
+  EXPECT_EQ(tok_number, tokens.kind(0));
+  EXPECT_EQ(0, tokens.value(0).integer);
+  EXPECT_EQ(42, tokens.value(1).integer);
+  EXPECT_EQ(2147483647, tokens.value(2).integer);
+  // out of range saturates instead of throwing
+  EXPECT_EQ(INT32_MAX, tokens.value(3).integer);
+  EXPECT_EQ(tok_float_literal, tokens.kind(4));
+  EXPECT_EQ(1.5f, tokens.value(4).real);
+  EXPECT_EQ(tok_float_literal, tokens.kind(5));
+  EXPECT_EQ(0.25f, tokens.value(5).real);
+  EXPECT_EQ(3.0f, tokens.get(6).value.real);
+
+  const diagnostics_t &diagnostics = this->tp_lexer->diagnostics();
+  ASSERT_EQ(1u, diagnostics.entries().size());
+  EXPECT_EQ(tokens.offset(3), diagnostics.entries()[0].offset);
+  EXPECT_EQ("integer literal out of range", diagnostics.entries()[0].message);
+}
+
+TEST_F(lexer_unit_test, lex_recovers_from_errors) {
+  std::string source = "int @@ x = 1;\n$ \"open\nx = .;";
+  token_buffer_t tokens = this->tp_lexer->lex(source);
+
+  std::vector<token_e> kinds = {tok_int,    tok_error,  tok_id,    tok_assign,
+                                tok_number, tok_semicolon, tok_error, tok_error,
+                                tok_id,     tok_id,     tok_assign, tok_error,
+                                tok_semicolon, tok_eof};
+  ASSERT_EQ(kinds.size(), tokens.size());
+  for (token_index_t i = 0; i < tokens.size(); i++) {
+    EXPECT_EQ(kinds[i], tokens.kind(i)) << "token " << i;
+  }
+  // a run of bad bytes is one token, it ends where a token can start
+  EXPECT_EQ("@@", tokens.text(1));
+  EXPECT_EQ("\"", tokens.text(7));
+  EXPECT_EQ("open", tokens.text(8));
+
+  const diagnostics_t &diagnostics = this->tp_lexer->diagnostics();
+  ASSERT_EQ(4u, diagnostics.entries().size());
+  EXPECT_EQ(4u, diagnostics.entries()[0].offset);
+  EXPECT_EQ(2u, diagnostics.entries()[0].length);
+  EXPECT_EQ("unexpected characters", diagnostics.entries()[0].message);
+  EXPECT_EQ("unexpected character", diagnostics.entries()[1].message);
+
+  // a new source starts with no diagnostics
+  this->tp_lexer->lex("int x;");
+  EXPECT_TRUE(this->tp_lexer->diagnostics().empty());
+}
+
+// the generator writes in pieces that split lines and tokens, the lexer reads
+// in chunks that do not line up with them
+TEST_F(lexer_unit_test, stream_from_pipe_matches_lex) {
+  std::string source;
+  for (int i = 0; i < 200; i++) {
+    std::string n = std::to_string(i);
+    source += "int value_" + n + " = value_" + n + " * 3 + 1.5; // note " +
+              n + "\n  \"text\" 'c' @ " + n + "\n";
+  }
+  source += "int a_line_longer_than_a_chunk_without_newline = 12345";
+  token_buffer_t expected = this->tp_lexer->lex(source);
+
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  std::thread writer = std::thread([&]() {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> piece(1, 40);
+    for (size_t pos = 0; pos < source.length();) {
+      size_t n = std::min(piece(rng), source.length() - pos);
+      ASSERT_EQ(static_cast<ssize_t>(n), write(fds[1], source.data() + pos, n));
+      pos += n;
+    }
+    close(fds[1]);
+  });
+
+  source_stream_t stream = source_stream_t(fds[0], 16);
+  lexer::lexer_t lxr = lexer::lexer_t(stream);
+  for (token_index_t i = 0; i < expected.size(); i++) {
+    // look ahead across refills, the peeked lexemes have to survive them
+    const token_t &ahead = lxr.peek(std::min<size_t>(
+        lexer::lexer_t::max_lookahead - 1, expected.size() - 1 - i));
+    (void)ahead;
+    token_t tok = lxr.next_token();
+    EXPECT_EQ(expected.kind(i), tok.e_tok_type) << "token " << i;
+    EXPECT_EQ(expected.offset(i), tok.offset) << "token " << i;
+    EXPECT_EQ(expected.text(i), tok.t_val) << "token " << i;
+    EXPECT_EQ(expected.symbol(i), tok.value.symbol) << "token " << i;
+  }
+  EXPECT_EQ(tok_eof, lxr.next_token().e_tok_type);
+  EXPECT_EQ(source.length(), lxr.get_offset());
+  writer.join();
+  close(fds[0]);
+
+  // diagnostics count from the start of the stream as well
+  const diagnostics_t &diagnostics = lxr.diagnostics();
+  ASSERT_EQ(diagnostics_t::default_limit, diagnostics.entries().size());
+  EXPECT_EQ(200u - diagnostics_t::default_limit, diagnostics.dropped());
+  EXPECT_EQ(source.find('@'), diagnostics.entries()[0].offset);
+  EXPECT_EQ(source.find('@', diagnostics.entries()[98].offset + 1),
+            diagnostics.entries()[99].offset);
+}
+
+// a bad byte on every line must not grow the diagnostics with the input
+TEST_F(lexer_unit_test, lex_malformed_input_keeps_diagnostics_bounded) {
+  const std::string broken_line = "  int value_12 = value_11 @ 3 + 17;\n";
+  const size_t lines = 1000;
+  std::string broken;
+  for (size_t i = 0; i < lines; i++) {
+    broken += broken_line;
+  }
+
+  lexer::lexer_t lxr;
+  token_buffer_t tokens = lxr.lex(broken);
+  EXPECT_EQ(diagnostics_t::default_limit, lxr.diagnostics().entries().size());
+  EXPECT_EQ(lines - diagnostics_t::default_limit,
+            lxr.diagnostics().dropped());
+}
+
+TEST_F(lexer_unit_test, lex_longest_match) {
+  std::string source = "a<=b >= c==d!=e<f>g!h integer // x < y";
+  token_buffer_t tokens = this->tp_lexer->lex(source);
+
+  std::vector<token_e> expected = {
+      tok_id, tok_leq, tok_id, tok_geq, tok_id, tok_eq, tok_id,
+      tok_neq, tok_id, tok_lt, tok_id, tok_gt, tok_id, tok_exclaimationmark,
+      tok_id, tok_id, tok_eof};
+
+  ASSERT_EQ(expected.size(), tokens.size());
+  for (token_index_t i = 0; i < expected.size(); i++) {
+    EXPECT_EQ(expected[i], tokens.kind(i)) << "token " << i;
+  }
+  EXPECT_EQ("integer", tokens.text(15));
+}
+
+TEST_F(lexer_unit_test, stream_peek_does_not_consume) {
+  std::string source = "int a = 1;\nreturn a;";
+  lexer::lexer_t lxr = lexer::lexer_t(source);
+
+  EXPECT_EQ(tok_int, lxr.peek().e_tok_type);
+  EXPECT_EQ(tok_assign, lxr.peek(2).e_tok_type);
+  EXPECT_EQ(tok_return, lxr.peek(5).e_tok_type);
+  EXPECT_EQ(11u, lxr.peek(5).offset);
+  EXPECT_THROW(lxr.peek(lexer::lexer_t::max_lookahead), std::out_of_range);
+
+  std::vector<token_e> expected = {
+      tok_int,    tok_id, tok_assign,    tok_number, tok_semicolon,
+      tok_return, tok_id, tok_semicolon, tok_eof};
+  for (token_e kind : expected) {
+    EXPECT_EQ(kind, lxr.peek().e_tok_type);
+    EXPECT_EQ(kind, lxr.next_token().e_tok_type);
+  }
+  // the end of the stream repeats
+  EXPECT_EQ(tok_eof, lxr.peek(3).e_tok_type);
+  EXPECT_EQ(tok_eof, lxr.next_token().e_tok_type);
+}
+
+TEST_F(lexer_unit_test, lex_matches_regex_lexer_on_examples) {
+  expect_same_tokens("int main() {\n"
+                     "  int i = 10 * 2 - 2 + 8 / 2; // 20 - 2 + 4 = 22\n"
+                     "  return i;\n"
+                     "}\n");
+  expect_same_tokens("int half(int number) {\n"
+                     "  int result = number / 2; // comment at end of line\n"
+                     "\n"
+                     "  return result;\n"
+                     "}\n"
+                     "\n"
+                     "int main () {\n"
+                     "  int i = 5;\n"
+                     "  i = half(i);\n"
+                     "\n"
+                     "  return i;\n"
+                     "} // comment at end of file");
+  expect_same_tokens("int main (int argc, char *argv) {\n"
+                     "\tint n_times = 5;\n"
+                     "\tfor (int i = 0; i < n_times; i = i + 1) {\n"
+                     "\t\tprintf(\"%d. Hello World\\n\", i+1);\n"
+                     "\t\tchar c = 'x'; float f = 1.25 + .5;\n"
+                     "\t}\n"
+                     "\tif (!done) { while (x >= 1) { x = x - 1; } }\n"
+                     "\telse { return arr[0]; }\n"
+                     "}\n");
+}
+
+TEST_F(lexer_unit_test, lex_matches_regex_lexer_on_random_input) {
+  const std::vector<std::string> fragments = {
+      "int",   "integer", "if",   "ifx",   "else", "for",  "while", "return",
+      "bool",  "char",    "float", "void", "_a1",  "x",    "12",    "3.25",
+      ".5",    "\"str\"", "'c'",  "//comment\n", "<=", "<",  ">=",    ">",
+      "==",    "=",       "!=",   "!",     "+",    "-",    "*",     "/",
+      "(",     ")",       "{",    "}",     "[",    "]",    ",",     ";",
+      ":",     " ",       "\t",   "\n",
+      // long runs that reach the vector kernels
+      "a_rather_long_identifier_that_spans_two_vectors_0123456789",
+      "\n                                        ",
+      "// a comment that is longer than the inline scan limit\n",
+      // bytes no rule matches
+      "@", "$#", "\"open", "'", ".", "\r"};
+
+  std::mt19937 rng(1234);
+  std::uniform_int_distribution<size_t> pick(0, fragments.size() - 1);
+
+  for (int round = 0; round < 200; round++) {
+    std::string source;
+    for (int i = 0; i < 40; i++) {
+      source += fragments[pick(rng)];
+    }
+    expect_same_tokens(source);
+  }
+}
+
+void expect_same_buffers(const token_buffer_t &expected,
+                         const token_buffer_t &actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (token_index_t i = 0; i < expected.size(); i++) {
+    EXPECT_EQ(expected.kind(i), actual.kind(i)) << "token " << i;
+    EXPECT_EQ(expected.offset(i), actual.offset(i)) << "token " << i;
+    EXPECT_EQ(expected.length(i), actual.length(i)) << "token " << i;
+    EXPECT_EQ(expected.symbol(i), actual.symbol(i)) << "token " << i;
+  }
+}
+
+TEST_F(lexer_unit_test, relex_matches_full_lex_on_random_edits) {
+  const std::vector<std::string> fragments = {
+      "int", "x",  "12", "3.5", "\"s\"", "'c'", "//c\n", "<", "=", "!",
+      "/",   " ",  "\n", ";",   "(",     ")",   "{",     "}", ".", "\""};
+
+  std::mt19937 rng(99);
+  std::uniform_int_distribution<size_t> pick(0, fragments.size() - 1);
+
+  for (int round = 0; round < 300; round++) {
+    std::string old_source;
+    for (int i = 0; i < 60; i++) {
+      old_source += fragments[pick(rng)];
+    }
+    std::string inserted;
+    for (size_t i = rng() % 4; i > 0; i--) {
+      inserted += fragments[pick(rng)];
+    }
+    size_t offset = rng() % (old_source.length() + 1);
+    size_t removed = rng() % (old_source.length() - offset + 1) % 8;
+
+    std::string new_source = old_source;
+    new_source.replace(offset, removed, inserted);
+
+    lexer::lexer_t lxr;
+    token_buffer_t old_tokens = lxr.lex(old_source);
+    lexer::token_diff_t diff;
+    token_buffer_t tokens =
+        lxr.relex(old_tokens, new_source,
+                  lexer::source_edit_t{offset, removed, inserted.length()},
+                  &diff);
+
+    lexer::lexer_t reference;
+    SCOPED_TRACE(new_source);
+    expect_same_buffers(reference.lex(new_source), tokens);
+
+    // everything outside the diff is an old token, shifted
+    ASSERT_EQ(old_tokens.size() - diff.removed + diff.inserted, tokens.size());
+    for (token_index_t i = 0; i < diff.first; i++) {
+      EXPECT_EQ(old_tokens.offset(i), tokens.offset(i));
+    }
+    for (token_index_t i = diff.first + diff.removed; i < old_tokens.size();
+         i++) {
+      token_index_t j = i - diff.removed + diff.inserted;
+      EXPECT_EQ(old_tokens.kind(i), tokens.kind(j));
+      EXPECT_EQ(old_tokens.text(i), tokens.text(j));
+    }
+  }
+}
+
+TEST_F(lexer_unit_test, relex_stops_after_the_edit) {
+  std::string source;
+  for (int i = 0; i < 10000; i++) {
+    source += "  int value = other * 3; // line\n";
+  }
+  token_buffer_t tokens = this->tp_lexer->lex(source);
+
+  // rename one identifier in the middle of the file
+  size_t offset = source.find("other", source.length() / 2);
+  source.replace(offset, 5, "another");
+  lexer::token_diff_t diff;
+  tokens = this->tp_lexer->relex(std::move(tokens), source,
+                                 lexer::source_edit_t{offset, 5, 7}, &diff);
+  EXPECT_EQ(1u, diff.removed);
+  EXPECT_EQ(1u, diff.inserted);
+  EXPECT_EQ("another", tokens.text(diff.first));
+
+  // splitting a line moves everything after it down a line
+  source.insert(offset, "\n");
+  tokens = this->tp_lexer->relex(std::move(tokens), source,
+                                 lexer::source_edit_t{offset, 0, 1}, &diff);
+  EXPECT_LE(diff.inserted, 8u);
+  line_index_t lines = line_index_t(source);
+  EXPECT_EQ(10002u, lines.locate(tokens.offset(tokens.size() - 1)).line);
+
+  lexer::lexer_t reference;
+  expect_same_buffers(reference.lex(source), tokens);
 }
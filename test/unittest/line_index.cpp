@@ -0,0 +1,62 @@
+#include "line_index.h"
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace compiler;
+
+class line_index_unit_test : public ::testing::Test {
+protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+TEST_F(line_index_unit_test, locate_offsets) {
+  std::string source = "int x;\n\n  return x;\n";
+  line_index_t lines = line_index_t(source);
+
+  EXPECT_EQ(4u, lines.line_count());
+  EXPECT_EQ(8u, lines.line_start(3));
+
+  source_location_t loc = lines.locate(0);
+  EXPECT_EQ(1u, loc.line);
+  EXPECT_EQ(1u, loc.column);
+
+  // the line feed belongs to the line it ends
+  loc = lines.locate(6);
+  EXPECT_EQ(1u, loc.line);
+  EXPECT_EQ(7u, loc.column);
+
+  loc = lines.locate(7);
+  EXPECT_EQ(2u, loc.line);
+  EXPECT_EQ(1u, loc.column);
+
+  loc = lines.locate(10);
+  EXPECT_EQ(3u, loc.line);
+  EXPECT_EQ(3u, loc.column);
+
+  // the end of the source is the start of the last, empty line
+  loc = lines.locate(static_cast<uint32_t>(source.length()));
+  EXPECT_EQ(4u, loc.line);
+  EXPECT_EQ(1u, loc.column);
+}
+
+TEST_F(line_index_unit_test, long_source) {
+  std::string source;
+  for (int i = 0; i < 1000; i++) {
+    source += "  int value = other * 3; // line\n";
+  }
+  line_index_t lines = line_index_t(source);
+
+  ASSERT_EQ(1001u, lines.line_count());
+  for (uint32_t line = 1; line <= 1000; line++) {
+    uint32_t offset = lines.line_start(line) + 6;
+    EXPECT_EQ(line, lines.locate(offset).line);
+    EXPECT_EQ(7u, lines.locate(offset).column);
+  }
+}
+
+TEST_F(line_index_unit_test, empty_source) {
+  line_index_t lines = line_index_t("");
+  EXPECT_EQ(1u, lines.line_count());
+  EXPECT_EQ(1u, lines.locate(0).line);
+}
@@ -0,0 +1,69 @@
+#include "exceptions.h"
+#include "lexer/lexer.h"
+#include "parser/abstract_syntax_tree.h"
+#include "parser/parser.h"
+#include "token_buffer.h"
+#include "tokens.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using namespace compiler;
+using parser::ast::node::function_t;
+
+class parse_declarations_unit_test : public ::testing::Test {
+protected:
+  void SetUp() override {}
+  void TearDown() override {}
+
+  std::vector<parser::ast::abstract_syntax_tree_t *> *
+  parse_declarations(const std::string &source) {
+    this->tokens = lexer::lexer_t().lex(source);
+    return parser::parse_declarations(this->tokens);
+  }
+
+  token_buffer_t tokens;
+};
+
+TEST_F(parse_declarations_unit_test, bodies_are_parsed_on_first_use) {
+  std::string source = "int half(int number) {\n"
+                       "  int result = number / 2;\n"
+                       "  return result;\n"
+                       "}\n"
+                       "int limit = 10;\n"
+                       "int main() { return half(limit); }\n";
+
+  std::vector<parser::ast::abstract_syntax_tree_t *> *trees =
+      this->parse_declarations(source);
+  ASSERT_EQ(3, trees->size());
+
+  function_t *p_half = dynamic_cast<function_t *>((*trees)[0]->p_head);
+  ASSERT_NE(nullptr, p_half);
+  EXPECT_EQ("half", interner_t::global().spelling(p_half->identifier));
+  EXPECT_EQ(1, p_half->parameter_type_pointer_level_tuple->size());
+  EXPECT_EQ(nullptr, p_half->block);
+
+  ASSERT_NE(nullptr, p_half->body());
+  EXPECT_EQ(2, p_half->block->statements.size());
+  EXPECT_EQ(nullptr, p_half->p_deferred_body);
+
+  lexer::lexer_t lxr = lexer::lexer_t(source);
+  std::vector<parser::ast::abstract_syntax_tree_t *> *expected =
+      parser::parse_stream(lxr);
+  for (size_t i = 0; i < trees->size(); i++) {
+    EXPECT_EQ((*expected)[i]->p_head->debug_print(),
+              (*trees)[i]->p_head->debug_print());
+  }
+}
+
+TEST_F(parse_declarations_unit_test, body_errors_are_thrown_on_first_use) {
+  std::string source = "int f() { return missing; }\n"
+                       "int missing = 1;\n";
+
+  std::vector<parser::ast::abstract_syntax_tree_t *> *trees = nullptr;
+  ASSERT_NO_THROW(trees = this->parse_declarations(source));
+  ASSERT_EQ(2, trees->size());
+
+  function_t *p_f = static_cast<function_t *>((*trees)[0]->p_head);
+  EXPECT_THROW(p_f->body(), exceptions::variable_not_declared_error);
+}
@@ -0,0 +1,81 @@
+#include "exceptions.h"
+#include "lexer/lexer.h"
+#include "parser/abstract_syntax_tree.h"
+#include "parser/parser.h"
+#include "spdlog/fmt/bundled/format.h"
+#include "thread_pool.h"
+#include "token_buffer.h"
+#include "tokens.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using namespace compiler;
+
+class parse_parallel_unit_test : public ::testing::Test {
+protected:
+  void SetUp() override {}
+  void TearDown() override {}
+
+  /// parses the source on a pool of 4 threads
+  std::vector<parser::ast::abstract_syntax_tree_t *> *
+  parse_parallel(const std::string &source) {
+    this->tokens = lexer::lexer_t().lex(source);
+    return parser::parse_parallel(this->tokens, this->pool);
+  }
+
+  /// parses the source one definition after the other
+  std::vector<parser::ast::abstract_syntax_tree_t *> *
+  parse_sequential(const std::string &source) {
+    lexer::lexer_t lxr = lexer::lexer_t(source);
+    return parser::parse_stream(lxr);
+  }
+
+  thread_pool_t pool = thread_pool_t(4);
+  token_buffer_t tokens;
+};
+
+TEST_F(parse_parallel_unit_test, matches_sequential_parse) {
+  std::string source = "int counter = 0;\n";
+  for (int i = 0; i < 200; i++) {
+    source += fmt::format("int f{}(int a, int *b) {{\n"
+                          "  int x = a * {} + counter;\n"
+                          "  while (x > 0) x = x - 1;\n"
+                          "  return {};\n"
+                          "}}\n",
+                          i, i, i == 0 ? "x" : fmt::format("f{}(x, b)", i - 1));
+    if (i % 50 == 0) {
+      source += fmt::format("int g{} = f{}(1, 0);\n", i, i);
+    }
+  }
+
+  std::vector<parser::ast::abstract_syntax_tree_t *> *expected =
+      this->parse_sequential(source);
+  std::vector<parser::ast::abstract_syntax_tree_t *> *trees =
+      this->parse_parallel(source);
+
+  ASSERT_EQ(expected->size(), trees->size());
+  for (size_t i = 0; i < trees->size(); i++) {
+    EXPECT_EQ((*expected)[i]->p_head->debug_print(),
+              (*trees)[i]->p_head->debug_print())
+        << "definition " << i;
+  }
+}
+
+TEST_F(parse_parallel_unit_test, bodies_only_see_earlier_definitions) {
+  std::string source = "int f() { return later; }\n"
+                       "int later = 1;\n"
+                       "int g() { return f(); }\n";
+
+  EXPECT_THROW(this->parse_sequential(source),
+               exceptions::variable_not_declared_error);
+  EXPECT_THROW(this->parse_parallel(source),
+               exceptions::variable_not_declared_error);
+}
+
+TEST_F(parse_parallel_unit_test, unbalanced_braces_report_the_parse_error) {
+  std::string source = "int f() { return 1; }\n"
+                       "int g() { return 2; \n";
+
+  EXPECT_THROW(this->parse_parallel(source), exceptions::syntax_error);
+}
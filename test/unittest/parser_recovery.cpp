@@ -0,0 +1,121 @@
+#include "diagnostics.h"
+#include "exceptions.h"
+#include "interner.h"
+#include "lexer/lexer.h"
+#include "parser/abstract_syntax_tree.h"
+#include "parser/parser.h"
+#include "token_buffer.h"
+#include "tokens.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using namespace compiler;
+using parser::ast::node::function_t;
+
+class parser_recovery_unit_test : public ::testing::Test {
+protected:
+  void SetUp() override {}
+  void TearDown() override {}
+
+  std::vector<parser::ast::abstract_syntax_tree_t *> *
+  parse(const std::string &source, diagnostics_t *p_diagnostics) {
+    this->tokens = lexer::lexer_t().lex(source);
+    return parser::parse_tokens(this->tokens, p_diagnostics);
+  }
+
+  /// the text a diagnostic points at
+  std::string text(const std::string &source, const diagnostic_t &diagnostic) {
+    return source.substr(diagnostic.offset, diagnostic.length);
+  }
+
+  token_buffer_t tokens;
+};
+
+TEST_F(parser_recovery_unit_test, reports_every_error) {
+  std::string source = "int a = 1 + ;\n"
+                       "int f(int x) {\n"
+                       "  int y = x;\n"
+                       "  y = * 2;\n"
+                       "  if (x) y = x + ];\n"
+                       "  return y;\n"
+                       "}\n"
+                       "int g() { return f(1); }\n";
+
+  diagnostics_t diagnostics = diagnostics_t();
+  std::vector<parser::ast::abstract_syntax_tree_t *> *trees =
+      this->parse(source, &diagnostics);
+
+  ASSERT_EQ(3u, diagnostics.entries().size());
+  EXPECT_EQ(";", this->text(source, diagnostics.entries()[0]));
+  EXPECT_EQ("*", this->text(source, diagnostics.entries()[1]));
+  EXPECT_EQ("]", this->text(source, diagnostics.entries()[2]));
+
+  // the broken global is left out, the statements around errors are kept
+  ASSERT_EQ(2u, trees->size());
+  function_t *p_f = dynamic_cast<function_t *>((*trees)[0]->p_head);
+  ASSERT_NE(nullptr, p_f);
+  EXPECT_EQ(2u, p_f->body()->statements.size());
+  EXPECT_NE(nullptr, dynamic_cast<function_t *>((*trees)[1]->p_head));
+}
+
+TEST_F(parser_recovery_unit_test, resyncs_at_the_next_definition) {
+  std::string source = "int f(int x,, int y) { return x; }\n"
+                       "float h = ;\n"
+                       "int g() { return 2; }\n";
+
+  diagnostics_t diagnostics = diagnostics_t();
+  std::vector<parser::ast::abstract_syntax_tree_t *> *trees =
+      this->parse(source, &diagnostics);
+
+  ASSERT_EQ(2u, diagnostics.entries().size());
+  EXPECT_EQ(",", this->text(source, diagnostics.entries()[0]));
+  EXPECT_EQ(";", this->text(source, diagnostics.entries()[1]));
+  ASSERT_EQ(1u, trees->size());
+  function_t *p_g = dynamic_cast<function_t *>((*trees)[0]->p_head);
+  ASSERT_NE(nullptr, p_g);
+  EXPECT_EQ("g", interner_t::global().spelling(p_g->identifier));
+}
+
+TEST_F(parser_recovery_unit_test, cut_off_block_is_reported_once) {
+  std::string source = "int f() {\n"
+                       "  int x = 1;\n";
+
+  diagnostics_t diagnostics = diagnostics_t();
+  std::vector<parser::ast::abstract_syntax_tree_t *> *trees =
+      this->parse(source, &diagnostics);
+
+  EXPECT_EQ(1u, diagnostics.entries().size());
+  EXPECT_TRUE(trees->empty());
+}
+
+TEST_F(parser_recovery_unit_test, throws_without_diagnostics) {
+  EXPECT_THROW(this->parse("int a = 1 + ;\nint b = ;\n", nullptr),
+               exceptions::syntax_error);
+}
+
+TEST_F(parser_recovery_unit_test, stray_token_does_not_hide_the_next_error) {
+  std::string source = "int f(int x) {\n"
+                       "  ;\n"
+                       "  x = * 2;\n"
+                       "  { x = 1; }\n"
+                       "  x = ];\n"
+                       "  return x;\n"
+                       "}\n";
+
+  diagnostics_t diagnostics = diagnostics_t();
+  std::vector<parser::ast::abstract_syntax_tree_t *> *trees =
+      this->parse(source, &diagnostics);
+
+  ASSERT_EQ(4u, diagnostics.entries().size());
+  EXPECT_EQ(";", this->text(source, diagnostics.entries()[0]));
+  EXPECT_EQ("*", this->text(source, diagnostics.entries()[1]));
+  EXPECT_EQ("{", this->text(source, diagnostics.entries()[2]));
+  EXPECT_EQ("]", this->text(source, diagnostics.entries()[3]));
+
+  // the stray block is skipped as a whole, not merged into the body
+  ASSERT_EQ(1u, trees->size());
+  function_t *p_f = dynamic_cast<function_t *>((*trees)[0]->p_head);
+  ASSERT_NE(nullptr, p_f);
+  EXPECT_EQ(1u, p_f->body()->statements.size());
+}
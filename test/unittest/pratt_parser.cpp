@@ -1,372 +1,431 @@
 #include "parser/pratt_parser.h"
+#include "arena.h"
 #include "exceptions.h"
+#include "interner.h"
+#include "lexer/lexer.h"
 #include "parser/abstract_syntax_tree.h"
+#include "parser/token_cursor.h"
+#include "symbol_table.h"
+#include "token_buffer.h"
 #include "tokens.h"
+#include <functional>
 #include <gtest/gtest.h>
+#include <random>
 #include <string>
 #include <vector>
 
 using namespace compiler;
+using namespace compiler::parser::ast::node;
 
-// Example unit test for tokens module
-class pratt_parser_unit_test : public ::testing::Test {
-public:
-protected:
-  void SetUp() override {
-    // Setup code here
+// reference parser: the recursive Pratt parser parse_expression replaced,
+// one call per parenthesis, prefix operator, argument and right operand
+expression_t *recursive_operand(parser::token_cursor_t &tokens,
+                                symbol_table::symbol_table_t *p_st,
+                                arena_t *p_arena, int min_binding_power);
+
+void recursive_match(parser::token_cursor_t &tokens, token_e type) {
+  if (tokens.peek_kind() != type) {
+    throw exceptions::parser_error("Doesn't match expected token type",
+                                   tokens.peek());
   }
+  tokens.advance();
+}
 
-  void TearDown() override {
-    // Cleanup code here
+expression_t *recursive_literal(const token_t &tok, arena_t *p_arena) {
+  switch (tok.e_tok_type) {
+  case tok_number:
+    return p_arena->create<literal_expr_t>(
+        tok.e_tok_type, static_cast<int>(tok.value.integer));
+  case tok_float_literal:
+    return p_arena->create<literal_expr_t>(tok.e_tok_type, tok.value.real);
+  case tok_char_literal:
+    return p_arena->create<literal_expr_t>(tok.e_tok_type, tok.t_val[0]);
+  case tok_id:
+    return p_arena->create<literal_expr_t>(tok.e_tok_type, tok.value.symbol);
+  default:
+    return p_arena->create<literal_expr_t>(tok.e_tok_type,
+                                           p_arena->copy(tok.t_val));
   }
-};
+}
 
-TEST_F(pratt_parser_unit_test, parse_expression_eof) {
-  std::vector<token_t *> tokens;
-  tokens.push_back(create_token_t(tok_number, "3", 1));
-  tokens.push_back(create_token_t(tok_plus, "", 1));
-  tokens.push_back(create_token_t(tok_number, "4", 1));
-  tokens.push_back(create_token_t(tok_star, "", 1));
-  tokens.push_back(create_token_t(tok_number, "5", 1));
-  tokens.push_back(create_token_t(tok_eof, "", 1));
-  symbol_table::symbol_table_t st;
+expression_t *recursive_primary(parser::token_cursor_t &tokens,
+                                symbol_table::symbol_table_t *p_st,
+                                arena_t *p_arena) {
+  token_e kind = tokens.peek_kind();
+  if (kind == tok_lparen) {
+    tokens.advance();
+    expression_t *p_expr = recursive_operand(tokens, p_st, p_arena, 0);
+    recursive_match(tokens, tok_rparen);
+    return p_expr;
+  }
+  if (kind == tok_exclaimationmark || kind == tok_minus || kind == tok_plus) {
+    token_e op = tokens.advance().e_tok_type;
+    expression_t *p_operand = recursive_operand(
+        tokens, p_st, p_arena,
+        token_spec[tok_exclaimationmark].right_precidence);
+    return p_arena->create<unary_expr_t>(op, p_operand);
+  }
 
-  std::string expected = "(plus (number 3) (star (number 4) (number 5)))";
+  switch (kind) {
+  case tok_number:
+  case tok_float_literal:
+  case tok_string:
+  case tok_char_literal:
+    return recursive_literal(tokens.advance(), p_arena);
+  case tok_id: {
+    token_t id_tok = tokens.advance();
+    if (!p_st->is_defined(id_tok.value.symbol)) {
+      throw exceptions::variable_not_declared_error("identifier is not defined",
+                                                    id_tok);
+    }
+    if (tokens.peek_kind() != tok_lparen) {
+      return recursive_literal(id_tok, p_arena);
+    }
+    tokens.advance();
+    node_list_t<expression_t *> arguments;
+    while (tokens.peek_kind() != tok_eof && tokens.peek_kind() != tok_rparen) {
+      arguments.push_back(*p_arena,
+                          recursive_operand(tokens, p_st, p_arena, 0));
+      if (tokens.peek_kind() == tok_comma) {
+        tokens.advance();
+      }
+    }
+    recursive_match(tokens, tok_rparen);
+    return p_arena->create<call_expr_t>(id_tok.value.symbol, arguments);
+  }
+  default:
+    throw exceptions::parser_error("Expected primary expression",
+                                   tokens.peek());
+  }
+}
 
-  // CRITICAL: Reverse the tokens since parse_expression expects reversed order
-  std::reverse(tokens.begin(), tokens.end());
-  parser::ast::node::expression_t *ex =
-      parser::pratt_parser::parse_expression(tokens, &st);
+expression_t *recursive_operand(parser::token_cursor_t &tokens,
+                                symbol_table::symbol_table_t *p_st,
+                                arena_t *p_arena, int min_binding_power) {
+  expression_t *p_lhs = recursive_primary(tokens, p_st, p_arena);
+  while (true) {
+    token_e op = tokens.peek_kind();
+    if (parser::pratt_parser::get_left_binding_power(op) <=
+        min_binding_power) {
+      return p_lhs;
+    }
+    tokens.advance();
 
-  ASSERT_EQ(expected, ex->to_prefix_notation());
+    if (op == tok_lbracket) {
+      expression_t *p_index = recursive_operand(tokens, p_st, p_arena, 0);
+      recursive_match(tokens, tok_rbracket);
+      p_lhs = p_arena->create<subscript_expr_t>(p_lhs, p_index);
+      continue;
+    }
+    expression_t *p_rhs = recursive_operand(tokens, p_st, p_arena,
+                                            token_spec[op].right_precidence);
+    p_lhs = p_arena->create<binary_expr_t>(p_lhs, op, p_rhs);
+  }
 }
 
-TEST_F(pratt_parser_unit_test, parse_expression_semicolon) {
-  std::vector<token_t *> tokens;
-  tokens.push_back(create_token_t(tok_number, "1.2", 1));
-  tokens.push_back(create_token_t(tok_plus, "", 1));
-  tokens.push_back(create_token_t(tok_number, "4", 1));
-  tokens.push_back(create_token_t(tok_star, "", 1));
-  tokens.push_back(create_token_t(tok_minus, "", 1));
-  tokens.push_back(create_token_t(tok_number, "5", 1));
-  tokens.push_back(create_token_t(tok_semicolon, "", 1));
+expression_t *recursive_expression(parser::token_cursor_t &tokens,
+                                   symbol_table::symbol_table_t *p_st,
+                                   arena_t *p_arena) {
+  expression_t *p_expr = recursive_operand(tokens, p_st, p_arena, 0);
+  if (parser::pratt_parser::is_expression_delimiter(tokens.peek_kind())) {
+    tokens.advance();
+  }
+  return p_expr;
+}
+
+// a tree with the arguments of calls, which to_prefix_notation leaves out
+std::string dump(const expression_t *p_expr) {
+  if (auto *p_call = dynamic_cast<const call_expr_t *>(p_expr)) {
+    std::string s =
+        "(call " + interner_t::global().spelling(p_call->function_name);
+    for (const expression_t *p_argument : p_call->arguments) {
+      s += " " + dump(p_argument);
+    }
+    return s + ")";
+  }
+  if (auto *p_binary = dynamic_cast<const binary_expr_t *>(p_expr)) {
+    return "(" + token_t(p_binary->op, "", 0).type_name() + " " +
+           dump(p_binary->left) + " " + dump(p_binary->right) + ")";
+  }
+  if (auto *p_unary = dynamic_cast<const unary_expr_t *>(p_expr)) {
+    return "(" + token_t(p_unary->op, "", 0).type_name() + " " +
+           dump(p_unary->operand) + ")";
+  }
+  if (auto *p_subscript = dynamic_cast<const subscript_expr_t *>(p_expr)) {
+    return "(" + dump(p_subscript->array) + "[" + dump(p_subscript->index) +
+           "])";
+  }
+  return p_expr->to_prefix_notation();
+}
+
+class pratt_parser_unit_test : public ::testing::Test {
+public:
   symbol_table::symbol_table_t st;
+  lexer::lexer_t lxr;
+  arena_t arena;
+
+  /// declares an int variable, so it may appear in expressions
+  void declare(const char *t_name) {
+    this->st.add(this->arena.create<parser::ast::node::variable_t>(
+        tok_int, 0, interner_t::global().intern(t_name), nullptr));
+  }
 
-  std::string expected =
-      "(plus (number 1.2) (star (number 4) (minus (number 5))))";
+  /// parses the start of a source, the cursor is left after the expression
+  std::string parse(parser::token_cursor_t &cursor) {
+    return parser::pratt_parser::parse_expression(cursor, &this->st,
+                                                  &this->arena)
+        ->to_prefix_notation();
+  }
 
-  // CRITICAL: Reverse the tokens since parse_expression expects reversed order
-  std::reverse(tokens.begin(), tokens.end());
-  parser::ast::node::expression_t *ex =
-      parser::pratt_parser::parse_expression(tokens, &st);
+  std::string parse(const std::string &source) {
+    token_buffer_t tokens = this->lxr.lex(source);
+    parser::token_cursor_t cursor = parser::token_cursor_t(tokens);
+    return this->parse(cursor);
+  }
 
-  ASSERT_EQ(expected, ex->to_prefix_notation());
+protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+TEST_F(pratt_parser_unit_test, parse_expression_eof) {
+  EXPECT_EQ("(plus (number 3) (star (number 4) (number 5)))",
+            this->parse("3 + 4 * 5"));
+}
+
+TEST_F(pratt_parser_unit_test, parse_expression_semicolon) {
+  EXPECT_EQ("(plus (number 1) (star (number 4) (minus (number 5))))",
+            this->parse("1 + 4 * -5;"));
 }
 
 TEST_F(pratt_parser_unit_test, parse_expression_parentesies) {
-  std::vector<token_t *> tokens;
-  tokens.push_back(create_token_t(tok_lparen, "(", 1));
-  tokens.push_back(create_token_t(tok_number, "1.2", 1));
-  tokens.push_back(create_token_t(tok_plus, "", 1));
-  tokens.push_back(create_token_t(tok_number, "4", 1));
-  tokens.push_back(create_token_t(tok_rparen, ")", 1));
-  tokens.push_back(create_token_t(tok_star, "", 1));
-  tokens.push_back(create_token_t(tok_minus, "", 1));
-  tokens.push_back(create_token_t(tok_number, "5", 1));
-  tokens.push_back(create_token_t(tok_semicolon, "", 1));
-  symbol_table::symbol_table_t st;
+  EXPECT_EQ("(star (plus (number 1) (number 4)) (minus (number 5)))",
+            this->parse("(1 + 4) * -5;"));
+  EXPECT_EQ("(plus (star (number 2) (plus (number 1) (number 4))) (number 3))",
+            this->parse("2 * (1 + 4) + 3;"));
+}
 
-  std::string expected =
-      "(star (plus (number 1.2) (number 4)) (minus (number 5)))";
+TEST_F(pratt_parser_unit_test, parse_expression_associativity) {
+  this->declare("a");
+  this->declare("b");
+  EXPECT_EQ("(minus (minus (number 1) (number 2)) (number 3))",
+            this->parse("1 - 2 - 3;"));
+  EXPECT_EQ("(assign (id a) (assign (id b) (number 1)))",
+            this->parse("a = b = 1;"));
+  EXPECT_EQ("(lt (plus (id a) (number 1)) (star (id b) (number 2)))",
+            this->parse("a + 1 < b * 2;"));
+}
 
-  // CRITICAL: Reverse the tokens since parse_expression expects reversed order
-  std::reverse(tokens.begin(), tokens.end());
-  parser::ast::node::expression_t *ex =
-      parser::pratt_parser::parse_expression(tokens, &st);
+TEST_F(pratt_parser_unit_test, parse_expression_variable) {
+  this->declare("a");
+  EXPECT_EQ("(plus (id a) (number 5))", this->parse("a + 5;"));
+}
 
-  ASSERT_EQ(expected, ex->to_prefix_notation());
+TEST_F(pratt_parser_unit_test, parse_expression_variable_not_declared) {
+  EXPECT_THROW(this->parse("undeclared + 5;"),
+               exceptions::variable_not_declared_error);
 }
 
-TEST_F(pratt_parser_unit_test, parse_expression_variable) {
-  std::vector<token_t *> tokens;
-  tokens.push_back(create_token_t(tok_id, "a", 1));
-  tokens.push_back(create_token_t(tok_plus, "+", 1));
-  tokens.push_back(create_token_t(tok_number, "5", 1));
-  tokens.push_back(create_token_t(tok_semicolon, ";", 1));
+TEST_F(pratt_parser_unit_test, parse_expression_function_call_no_args) {
+  this->declare("foo");
+  EXPECT_EQ("(call foo)", this->parse("foo();"));
+}
 
-  symbol_table::symbol_table_t st;
-  parser::ast::node::literal_expr_t *expr =
-      new parser::ast::node::literal_expr_t(tok_number, "5");
-  parser::ast::node::variable_t var =
-      parser::ast::node::variable_t(tok_int, 0, "a", expr);
-  st.add(&var);
+TEST_F(pratt_parser_unit_test, parse_expression_array_in_arithmetic) {
+  this->declare("arr");
+  EXPECT_EQ("(plus ((id arr)[(number 0)]) (number 5))",
+            this->parse("arr[0] + 5;"));
+}
 
-  std::string expected = "(plus (id a) (number 5))";
+TEST_F(pratt_parser_unit_test, parse_expression_consumes_its_delimiter) {
+  this->declare("a");
+  token_buffer_t tokens = this->lxr.lex("a + 1; a * (2);");
+  parser::token_cursor_t cursor = parser::token_cursor_t(tokens);
+  EXPECT_EQ("(plus (id a) (number 1))", this->parse(cursor));
+  EXPECT_EQ(4u, cursor.position());
+  EXPECT_EQ("(star (id a) (number 2))", this->parse(cursor));
+  EXPECT_EQ(tok_eof, cursor.peek_kind());
+}
 
-  // CRITICAL: Reverse the tokens since parse_expression expects reversed order
-  std::reverse(tokens.begin(), tokens.end());
-  parser::ast::node::expression_t *ex =
-      parser::pratt_parser::parse_expression(tokens, &st);
+TEST_F(pratt_parser_unit_test, nodes_live_in_the_arena) {
+  this->declare("s");
+  std::string source = "s + \"text\" * (1 - -2);";
+  token_buffer_t tokens = this->lxr.lex(source);
+  parser::token_cursor_t cursor = parser::token_cursor_t(tokens);
+  size_t before = this->arena.size();
+  parser::ast::node::expression_t *p_expr =
+      parser::pratt_parser::parse_expression(cursor, &this->st, &this->arena);
 
-  ASSERT_EQ(expected, ex->to_prefix_notation());
+  // the string literal is copied, it does not point into the source
+  source.assign(source.length(), ' ');
+  EXPECT_EQ(
+      "(plus (id s) (star (string \"text\") (minus (number 1) (minus (number "
+      "2)))))",
+      p_expr->to_prefix_notation());
+  EXPECT_GE(this->arena.size() - before,
+            sizeof(parser::ast::node::binary_expr_t) * 3);
 }
 
-TEST_F(pratt_parser_unit_test, parse_expression_variable_not_declared) {
-  std::vector<token_t *> tokens;
-  tokens.push_back(create_token_t(tok_id, "a", 1));
-  tokens.push_back(create_token_t(tok_plus, "+", 1));
-  tokens.push_back(create_token_t(tok_number, "5", 1));
-  tokens.push_back(create_token_t(tok_semicolon, ";", 1));
+TEST_F(pratt_parser_unit_test, parse_expression_call_arguments) {
+  this->declare("f");
+  this->declare("a");
+  token_buffer_t tokens = this->lxr.lex("f(a, (1 + 2) * 3, f(a)[0]) + 1;");
+  parser::token_cursor_t cursor = parser::token_cursor_t(tokens);
+  auto *p_plus = dynamic_cast<parser::ast::node::binary_expr_t *>(
+      parser::pratt_parser::parse_expression(cursor, &this->st, &this->arena));
+  ASSERT_NE(nullptr, p_plus);
+  EXPECT_EQ(tok_eof, cursor.peek_kind());
 
-  symbol_table::symbol_table_t st;
+  auto *p_call = dynamic_cast<parser::ast::node::call_expr_t *>(p_plus->left);
+  ASSERT_NE(nullptr, p_call);
+  ASSERT_EQ(3u, p_call->arguments.size());
+  EXPECT_EQ("(id a)", p_call->arguments[0]->to_prefix_notation());
+  EXPECT_EQ("(star (plus (number 1) (number 2)) (number 3))",
+            p_call->arguments[1]->to_prefix_notation());
+  EXPECT_EQ("((call f)[(number 0)])",
+            p_call->arguments[2]->to_prefix_notation());
+}
+
+TEST_F(pratt_parser_unit_test, parse_expression_deep_nesting) {
+  // deep enough to overflow the call stack of a recursive descent
+  const size_t depth = 1000000;
+  std::string source;
+  for (size_t i = 0; i < depth; i++) {
+    source += "-(";
+  }
+  source += "1";
+  source.append(depth, ')');
+  source += ";";
 
-  std::string expected = "(plus (id a) (number 5))";
+  token_buffer_t tokens = this->lxr.lex(source);
+  parser::token_cursor_t cursor = parser::token_cursor_t(tokens);
+  parser::ast::node::expression_t *p_expr =
+      parser::pratt_parser::parse_expression(cursor, &this->st, &this->arena);
+  EXPECT_EQ(tok_eof, cursor.peek_kind());
 
-  // CRITICAL: Reverse the tokens since parse_expression expects reversed order
-  std::reverse(tokens.begin(), tokens.end());
-  ASSERT_THROW(parser::pratt_parser::parse_expression(tokens, &st),
-               exceptions::variable_not_declared_error);
+  // walked in a loop, the recursive to_prefix_notation would overflow
+  size_t n_unary = 0;
+  while (auto *p_unary =
+             dynamic_cast<parser::ast::node::unary_expr_t *>(p_expr)) {
+    EXPECT_EQ(tok_minus, p_unary->op);
+    p_expr = p_unary->operand;
+    n_unary++;
+  }
+  EXPECT_EQ(depth, n_unary);
+  EXPECT_EQ("(number 1)", p_expr->to_prefix_notation());
 }
 
-TEST_F(pratt_parser_unit_test, parse_expression_function_call_no_args) {
-  std::vector<token_t *> tokens;
-  tokens.push_back(create_token_t(tok_id, "foo", 1));
-  tokens.push_back(create_token_t(tok_lparen, "(", 1));
-  tokens.push_back(create_token_t(tok_rparen, ")", 1));
-  tokens.push_back(create_token_t(tok_semicolon, ";", 1));
+/// the tree, or the error, and where the cursor was left
+std::string parse_outcome(parser::token_cursor_t &cursor, bool recursive,
+                          symbol_table::symbol_table_t *p_st,
+                          arena_t *p_arena) {
+  std::string outcome;
+  try {
+    expression_t *p_expr =
+        recursive
+            ? recursive_expression(cursor, p_st, p_arena)
+            : parser::pratt_parser::parse_expression(cursor, p_st, p_arena);
+    outcome = dump(p_expr);
+  } catch (exceptions::syntax_error &err) {
+    outcome = err.what();
+  }
+  return outcome + " at " + std::to_string(cursor.position());
+}
 
-  symbol_table::symbol_table_t st;
-  // Declare function 'foo' with no parameters
-  parser::ast::node::function_t func =
-      parser::ast::node::function_t(tok_void, 0, "foo", {}, nullptr);
-  st.add(&func);
+TEST_F(pratt_parser_unit_test, parse_expression_matches_recursive_parser) {
+  this->declare("a");
+  this->declare("b");
+  this->declare("f");
+  const std::vector<std::string> atoms = {"a", "b", "1", "42", "2.5",
+                                          "'c'", "\"s\""};
+  const std::vector<std::string> infix = {"+",  "-",  "*",  "/", "=",
+                                          "==", "!=", "<",  "<=", ">",
+                                          ">="};
+  // tokens that break an expression when dropped into it
+  const std::vector<std::string> garbage = {"(", ")", "[", "]", ",", ";",
+                                            "=", "-", "{", "}", "if",
+                                            "undeclared"};
 
-  std::string expected = "(call foo)";
+  std::mt19937 rng(2024);
+  auto pick = [&rng](size_t n) {
+    return std::uniform_int_distribution<size_t>(0, n - 1)(rng);
+  };
 
-  std::reverse(tokens.begin(), tokens.end());
-  parser::ast::node::expression_t *ex =
-      parser::pratt_parser::parse_expression(tokens, &st);
+  // a valid expression as a list of lexemes, at most depth levels deep
+  std::function<void(std::vector<std::string> &, int)> generate =
+      [&](std::vector<std::string> &out, int depth) {
+        size_t shape = depth > 0 ? pick(7) : 0;
+        switch (shape) {
+        case 0:
+          out.push_back(atoms[pick(atoms.size())]);
+          break;
+        case 1:
+          out.push_back("(");
+          generate(out, depth - 1);
+          out.push_back(")");
+          break;
+        case 2:
+          out.push_back(pick(2) ? "-" : "!");
+          generate(out, depth - 1);
+          break;
+        case 3: {
+          out.push_back("f");
+          out.push_back("(");
+          size_t n_arguments = pick(4);
+          for (size_t i = 0; i < n_arguments; i++) {
+            if (i > 0) {
+              out.push_back(",");
+            }
+            generate(out, depth - 1);
+          }
+          out.push_back(")");
+          break;
+        }
+        case 4:
+          generate(out, depth - 1);
+          out.push_back("[");
+          generate(out, depth - 1);
+          out.push_back("]");
+          break;
+        default:
+          generate(out, depth - 1);
+          out.push_back(infix[pick(infix.size())]);
+          generate(out, depth - 1);
+          break;
+        }
+      };
 
-  ASSERT_EQ(expected, ex->to_prefix_notation());
-}
+  for (int round = 0; round < 20000; round++) {
+    std::vector<std::string> lexemes;
+    generate(lexemes, 6);
+    lexemes.push_back(";");
+    // every other expression is corrupted by a dropped, replaced or added
+    // token
+    if (round % 2 == 1) {
+      size_t at = pick(lexemes.size());
+      switch (pick(3)) {
+      case 0:
+        lexemes.erase(lexemes.begin() + at);
+        break;
+      case 1:
+        lexemes[at] = garbage[pick(garbage.size())];
+        break;
+      default:
+        lexemes.insert(lexemes.begin() + at, garbage[pick(garbage.size())]);
+        break;
+      }
+    }
+    std::string source;
+    for (const std::string &lexeme : lexemes) {
+      source += lexeme + " ";
+    }
+    source += "1;";
 
-// TEST_F(pratt_parser_unit_test, parse_expression_function_call_one_arg) {
-//   std::vector<token_t *> tokens;
-//   tokens.push_back(create_token_t(tok_id, "foo", 1));
-//   tokens.push_back(create_token_t(tok_lparen, "(", 1));
-//   tokens.push_back(create_token_t(tok_number, "5", 1));
-//   tokens.push_back(create_token_t(tok_rparen, ")", 1));
-//   tokens.push_back(create_token_t(tok_semicolon, ";", 1));
-//
-//   symbol_table::symbol_table_t st;
-//   parser::ast::node::function_t func =
-//       parser::ast::node::function_t(tok_int, 0, "foo", {}, nullptr);
-//   st.add(&func);
-//
-//   std::string expected = "(call foo (number 5))";
-//
-//   std::reverse(tokens.begin(), tokens.end());
-//   parser::ast::node::expression_t *ex =
-//       parser::pratt_parser::parse_expression(tokens, &st);
-//
-//   ASSERT_EQ(expected, ex->to_prefix_notation());
-// }
-//
-// TEST_F(pratt_parser_unit_test, parse_expression_function_call_multiple_args)
-// {
-//   std::vector<token_t *> tokens;
-//   tokens.push_back(create_token_t(tok_id, "add", 1));
-//   tokens.push_back(create_token_t(tok_lparen, "(", 1));
-//   tokens.push_back(create_token_t(tok_number, "3", 1));
-//   tokens.push_back(create_token_t(tok_comma, ",", 1));
-//   tokens.push_back(create_token_t(tok_number, "7", 1));
-//   tokens.push_back(create_token_t(tok_comma, ",", 1));
-//   tokens.push_back(create_token_t(tok_number, "10", 1));
-//   tokens.push_back(create_token_t(tok_rparen, ")", 1));
-//   tokens.push_back(create_token_t(tok_semicolon, ";", 1));
-//
-//   symbol_table::symbol_table_t st;
-//   parser::ast::node::function_t func =
-//       parser::ast::node::function_t(tok_int, 0, "add", {}, nullptr);
-//   st.add(&func);
-//
-//   std::string expected = "(call add (number 3) (number 7) (number 10))";
-//
-//   std::reverse(tokens.begin(), tokens.end());
-//   parser::ast::node::expression_t *ex =
-//       parser::pratt_parser::parse_expression(tokens, &st);
-//
-//   ASSERT_EQ(expected, ex->to_prefix_notation());
-// }
-//
-// TEST_F(pratt_parser_unit_test,
-//        parse_expression_function_call_with_expression_args) {
-//   std::vector<token_t *> tokens;
-//   tokens.push_back(create_token_t(tok_id, "calculate", 1));
-//   tokens.push_back(create_token_t(tok_lparen, "(", 1));
-//   tokens.push_back(create_token_t(tok_number, "3", 1));
-//   tokens.push_back(create_token_t(tok_plus, "+", 1));
-//   tokens.push_back(create_token_t(tok_number, "2", 1));
-//   tokens.push_back(create_token_t(tok_comma, ",", 1));
-//   tokens.push_back(create_token_t(tok_number, "7", 1));
-//   tokens.push_back(create_token_t(tok_star, "*", 1));
-//   tokens.push_back(create_token_t(tok_number, "4", 1));
-//   tokens.push_back(create_token_t(tok_rparen, ")", 1));
-//   tokens.push_back(create_token_t(tok_semicolon, ";", 1));
-//
-//   symbol_table::symbol_table_t st;
-//   parser::ast::node::function_t func =
-//       parser::ast::node::function_t(tok_int, 0, "calculate", {}, nullptr);
-//   st.add(&func);
-//
-//   std::string expected = "(call calculate (plus (number 3) (number 2)) (star
-//   "
-//                          "(number 7) (number 4)))";
-//
-//   std::reverse(tokens.begin(), tokens.end());
-//   parser::ast::node::expression_t *ex =
-//       parser::pratt_parser::parse_expression(tokens, &st);
-//
-//   ASSERT_EQ(expected, ex->to_prefix_notation());
-// }
-//
-// TEST_F(pratt_parser_unit_test, parse_expression_function_not_declared) {
-//   std::vector<token_t *> tokens;
-//   tokens.push_back(create_token_t(tok_id, "undefined_func", 1));
-//   tokens.push_back(create_token_t(tok_lparen, "(", 1));
-//   tokens.push_back(create_token_t(tok_number, "5", 1));
-//   tokens.push_back(create_token_t(tok_rparen, ")", 1));
-//   tokens.push_back(create_token_t(tok_semicolon, ";", 1));
-//
-//   symbol_table::symbol_table_t st;
-//
-//   std::reverse(tokens.begin(), tokens.end());
-//   ASSERT_THROW(parser::pratt_parser::parse_expression(tokens, &st),
-//                exceptions::variable_not_declared_error);
-// }
-//
-// TEST_F(pratt_parser_unit_test, parse_expression_array_access) {
-//   std::vector<token_t *> tokens;
-//   tokens.push_back(create_token_t(tok_id, "arr", 1));
-//   tokens.push_back(create_token_t(tok_lbracket, "[", 1));
-//   tokens.push_back(create_token_t(tok_number, "0", 1));
-//   tokens.push_back(create_token_t(tok_rbracket, "]", 1));
-//   tokens.push_back(create_token_t(tok_semicolon, ";", 1));
-//
-//   symbol_table::symbol_table_t st;
-//   parser::ast::node::variable_t arr = parser::ast::node::variable_t(
-//       tok_int, 0, "arr", nullptr); // TODO: implement size:  array of size 10
-//   st.add(&arr);
-//
-//   std::string expected = "(array_access arr (number 0))";
-//
-//   std::reverse(tokens.begin(), tokens.end());
-//   parser::ast::node::expression_t *ex =
-//       parser::pratt_parser::parse_expression(tokens, &st);
-//
-//   ASSERT_EQ(expected, ex->to_prefix_notation());
-// }
-//
-// TEST_F(pratt_parser_unit_test, parse_expression_array_access_with_expression)
-// {
-//   std::vector<token_t *> tokens;
-//   tokens.push_back(create_token_t(tok_id, "arr", 1));
-//   tokens.push_back(create_token_t(tok_lbracket, "[", 1));
-//   tokens.push_back(create_token_t(tok_id, "i", 1));
-//   tokens.push_back(create_token_t(tok_plus, "+", 1));
-//   tokens.push_back(create_token_t(tok_number, "1", 1));
-//   tokens.push_back(create_token_t(tok_rbracket, "]", 1));
-//   tokens.push_back(create_token_t(tok_semicolon, ";", 1));
-//
-//   symbol_table::symbol_table_t st;
-//   parser::ast::node::variable_t arr = parser::ast::node::variable_t(
-//       tok_int, 0, "arr", nullptr); // TODO: array size
-//   parser::ast::node::literal_expr_t *i_expr =
-//       new parser::ast::node::literal_expr_t(tok_number, "0");
-//   parser::ast::node::variable_t i_var =
-//       parser::ast::node::variable_t(tok_int, 0, "i", i_expr);
-//   st.add(&arr);
-//   st.add(&i_var);
-//
-//   std::string expected = "(array_access arr (plus (id i) (number 1)))";
-//
-//   std::reverse(tokens.begin(), tokens.end());
-//   parser::ast::node::expression_t *ex =
-//       parser::pratt_parser::parse_expression(tokens, &st);
-//
-//   ASSERT_EQ(expected, ex->to_prefix_notation());
-// }
-//
-// TEST_F(pratt_parser_unit_test, parse_expression_nested_array_access) {
-//   std::vector<token_t *> tokens;
-//   tokens.push_back(create_token_t(tok_id, "matrix", 1));
-//   tokens.push_back(create_token_t(tok_lbracket, "[", 1));
-//   tokens.push_back(create_token_t(tok_number, "0", 1));
-//   tokens.push_back(create_token_t(tok_rbracket, "]", 1));
-//   tokens.push_back(create_token_t(tok_lbracket, "[", 1));
-//   tokens.push_back(create_token_t(tok_number, "1", 1));
-//   tokens.push_back(create_token_t(tok_rbracket, "]", 1));
-//   tokens.push_back(create_token_t(tok_semicolon, ";", 1));
-//
-//   symbol_table::symbol_table_t st;
-//   parser::ast::node::variable_t matrix = parser::ast::node::variable_t(
-//       tok_int, 0, "matrix", nullptr); // TODO: array size. 2D array
-//   st.add(&matrix);
-//
-//   std::string expected =
-//       "(array_access (array_access matrix (number 0)) (number 1))";
-//
-//   std::reverse(tokens.begin(), tokens.end());
-//   parser::ast::node::expression_t *ex =
-//       parser::pratt_parser::parse_expression(tokens, &st);
-//
-//   ASSERT_EQ(expected, ex->to_prefix_notation());
-// }
-//
-// TEST_F(pratt_parser_unit_test, parse_expression_array_in_arithmetic) {
-//   std::vector<token_t *> tokens;
-//   tokens.push_back(create_token_t(tok_id, "arr", 1));
-//   tokens.push_back(create_token_t(tok_lbracket, "[", 1));
-//   tokens.push_back(create_token_t(tok_number, "0", 1));
-//   tokens.push_back(create_token_t(tok_rbracket, "]", 1));
-//   tokens.push_back(create_token_t(tok_plus, "+", 1));
-//   tokens.push_back(create_token_t(tok_number, "5", 1));
-//   tokens.push_back(create_token_t(tok_semicolon, ";", 1));
-//
-//   symbol_table::symbol_table_t st;
-//   parser::ast::node::variable_t arr = parser::ast::node::variable_t(
-//       tok_int, 0, "arr", nullptr); // TODO: array size.
-//   st.add(&arr);
-//
-//   std::string expected = "(plus (array_access arr (number 0)) (number 5))";
-//
-//   std::reverse(tokens.begin(), tokens.end());
-//   parser::ast::node::expression_t *ex =
-//       parser::pratt_parser::parse_expression(tokens, &st);
-//
-//   ASSERT_EQ(expected, ex->to_prefix_notation());
-// }
-//
-// TEST_F(pratt_parser_unit_test, parse_expression_function_call_in_arithmetic)
-// {
-//   std::vector<token_t *> tokens;
-//   tokens.push_back(create_token_t(tok_id, "getValue", 1));
-//   tokens.push_back(create_token_t(tok_lparen, "(", 1));
-//   tokens.push_back(create_token_t(tok_rparen, ")", 1));
-//   tokens.push_back(create_token_t(tok_star, "*", 1));
-//   tokens.push_back(create_token_t(tok_number, "2", 1));
-//   tokens.push_back(create_token_t(tok_semicolon, ";", 1));
-//
-//   symbol_table::symbol_table_t st;
-//   parser::ast::node::function_t func =
-//       parser::ast::node::function_t(tok_int, 0, "getValue", {}, nullptr);
-//   st.add(&func);
-//
-//   std::string expected = "(star (call getValue) (number 2))";
-//
-//   std::reverse(tokens.begin(), tokens.end());
-//   parser::ast::node::expression_t *ex =
-//       parser::pratt_parser::parse_expression(tokens, &st);
-//
-//   ASSERT_EQ(expected, ex->to_prefix_notation());
-// }
+    token_buffer_t tokens = this->lxr.lex(source);
+    parser::token_cursor_t expected_cursor = parser::token_cursor_t(tokens);
+    parser::token_cursor_t cursor = parser::token_cursor_t(tokens);
+    ASSERT_EQ(parse_outcome(expected_cursor, true, &this->st, &this->arena),
+              parse_outcome(cursor, false, &this->st, &this->arena))
+        << source;
+  }
+}
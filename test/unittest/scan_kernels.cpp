@@ -0,0 +1,76 @@
+#include "lexer/scan_kernels.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace compiler;
+
+class scan_kernels_unit_test : public ::testing::Test {
+protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+TEST_F(scan_kernels_unit_test, best_kernels_are_supported) {
+  std::vector<const lexer::scan_kernels_t *> kernels =
+      lexer::supported_scan_kernels();
+
+  ASSERT_FALSE(kernels.empty());
+  EXPECT_EQ(&lexer::scalar_scan_kernels(), kernels.front());
+  EXPECT_EQ(&lexer::scan_kernels(), kernels.back());
+}
+
+// every vector kernel has to agree with the scalar loops for runs of any
+// length, starting at any alignment, including runs that hit the end
+TEST_F(scan_kernels_unit_test, kernels_match_scalar) {
+  const std::string alphabet = "  \t\n\n\raz_AZ09/.;\"\x80\xff";
+  const lexer::scan_kernels_t &scalar = lexer::scalar_scan_kernels();
+
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<size_t> pick(0, alphabet.length() - 1);
+  std::uniform_int_distribution<size_t> run(0, 100);
+
+  for (const lexer::scan_kernels_t *p_kernels :
+       lexer::supported_scan_kernels()) {
+    for (int round = 0; round < 500; round++) {
+      // long runs of one class followed by random bytes
+      std::string text;
+      const char *fills[] = {" \n\t", "aZ_9", "x"};
+      std::string fill = fills[round % 3];
+      for (size_t i = run(rng); i > 0; i--) {
+        text += fill[i % fill.length()];
+      }
+      for (size_t i = run(rng); i > 0; i--) {
+        text += alphabet[pick(rng)];
+      }
+
+      for (size_t start = 0; start <= text.length(); start += 7) {
+        const char *p = text.data() + start;
+        const char *end = text.data() + text.length();
+
+        EXPECT_EQ(scalar.skip_whitespace(p, end),
+                  p_kernels->skip_whitespace(p, end))
+            << p_kernels->name;
+        EXPECT_EQ(scalar.skip_identifier(p, end),
+                  p_kernels->skip_identifier(p, end))
+            << p_kernels->name;
+        EXPECT_EQ(scalar.find_line_end(p, end),
+                  p_kernels->find_line_end(p, end))
+            << p_kernels->name;
+        EXPECT_EQ(scalar.count_newlines(p, end),
+                  p_kernels->count_newlines(p, end))
+            << p_kernels->name;
+
+        std::vector<uint32_t> expected(scalar.count_newlines(p, end));
+        std::vector<uint32_t> found(expected.size());
+        ASSERT_EQ(expected.size(),
+                  scalar.find_newlines(p, end, 5, expected.data()));
+        ASSERT_EQ(found.size(),
+                  p_kernels->find_newlines(p, end, 5, found.data()))
+            << p_kernels->name;
+        EXPECT_EQ(expected, found) << p_kernels->name;
+      }
+    }
+  }
+}
@@ -0,0 +1,62 @@
+#include "source_buffer.h"
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <utility>
+
+using namespace compiler;
+
+class source_buffer_unit_test : public ::testing::Test {
+protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+TEST_F(source_buffer_unit_test, map_regular_file) {
+  std::string path = testing::TempDir() + "source_buffer_test.lang";
+  std::string text = "int main() {\n  return 0;\n}\n";
+  FILE *p_file = fopen(path.c_str(), "wb");
+  ASSERT_NE(nullptr, p_file);
+  fwrite(text.data(), 1, text.size(), p_file);
+  fclose(p_file);
+
+  source_buffer_t source = source_buffer_t(path);
+  EXPECT_TRUE(source.is_mapped());
+  EXPECT_EQ(text, source.view());
+  EXPECT_EQ(path, source.path());
+
+  // moving keeps the mapping alive
+  source_buffer_t moved = std::move(source);
+  EXPECT_EQ(text, moved.view());
+  EXPECT_EQ(0u, source.size());
+
+  remove(path.c_str());
+}
+
+TEST_F(source_buffer_unit_test, read_pipe) {
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  std::string text = "int x = 1;\n";
+  ASSERT_EQ(static_cast<ssize_t>(text.size()),
+            write(fds[1], text.data(), text.size()));
+  close(fds[1]);
+
+  source_buffer_t source =
+      source_buffer_t("/dev/fd/" + std::to_string(fds[0]));
+  close(fds[0]);
+
+  EXPECT_FALSE(source.is_mapped());
+  EXPECT_EQ(text, source.view());
+}
+
+TEST_F(source_buffer_unit_test, from_string) {
+  source_buffer_t source = source_buffer_t::from_string("return 0;");
+  EXPECT_FALSE(source.is_mapped());
+  EXPECT_EQ("return 0;", source.view());
+}
+
+TEST_F(source_buffer_unit_test, missing_file) {
+  EXPECT_THROW(source_buffer_t("/nonexistent/file.lang"), std::runtime_error);
+}
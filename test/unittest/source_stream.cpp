@@ -0,0 +1,34 @@
+#include "source_stream.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <unistd.h>
+
+using namespace compiler;
+
+class source_stream_unit_test : public ::testing::Test {
+protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+TEST_F(source_stream_unit_test, reads_in_chunks) {
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  std::string text = "int x = 1;\nx = x + 2;\n";
+  ASSERT_EQ(static_cast<ssize_t>(text.size()),
+            write(fds[1], text.data(), text.size()));
+  close(fds[1]);
+
+  source_stream_t stream = source_stream_t(fds[0], 8);
+  std::string buffer = "kept";
+  EXPECT_EQ(8u, stream.read_chunk(&buffer));
+  EXPECT_EQ("keptint x = ", buffer);
+  EXPECT_FALSE(stream.at_end());
+
+  while (stream.read_chunk(&buffer) > 0) {
+  }
+  EXPECT_TRUE(stream.at_end());
+  EXPECT_EQ("kept" + text, buffer);
+  EXPECT_EQ(0u, stream.read_chunk(&buffer));
+  close(fds[0]);
+}
@@ -1,5 +1,7 @@
 #include "symbol_table.h"
+#include "arena.h"
 #include "exceptions.h"
+#include "interner.h"
 #include "parser/abstract_syntax_tree.h"
 #include "tokens.h"
 #include <gtest/gtest.h>
@@ -8,6 +10,10 @@
 
 using namespace compiler;
 
+symbol_id_t sym(const char *t_spelling) {
+  return interner_t::global().intern(t_spelling);
+}
+
 class symbol_table_unit_test : public ::testing::Test {
 public:
   symbol_table::symbol_table_t *p_st;
@@ -19,14 +25,14 @@ protected:
 
 TEST_F(symbol_table_unit_test, general_syntax_test) {
   parser::ast::node::variable_t *p_var = new parser::ast::node::variable_t(
-      tok_int, 0, "var_name",
+      tok_int, 0, sym("var_name"),
       new parser::ast::node::literal_expr_t(tok_int, 5));
 
   p_st->add(p_var);
 
   ASSERT_EQ(1, p_st->table.size());
   symbol_table::data_t *table_data;
-  table_data = p_st->table["var_name"];
+  table_data = p_st->table[sym("var_name")];
   ASSERT_EQ(tok_int, table_data->type);
   ASSERT_EQ(0, table_data->pointer_level);
   ASSERT_FALSE(table_data->is_static);
@@ -37,14 +43,14 @@ TEST_F(symbol_table_unit_test, general_syntax_test) {
 
 TEST_F(symbol_table_unit_test, variable_int_test) {
   parser::ast::node::variable_t *p_var = new parser::ast::node::variable_t(
-      tok_int, 0, "var_name",
+      tok_int, 0, sym("var_name"),
       new parser::ast::node::literal_expr_t(tok_int, "5"));
 
   p_st->add(p_var);
 
   ASSERT_EQ(1, p_st->table.size());
   symbol_table::data_t *table_data;
-  table_data = p_st->table["var_name"];
+  table_data = p_st->table[sym("var_name")];
   ASSERT_EQ(tok_int, table_data->type);
   ASSERT_EQ(0, table_data->pointer_level);
   ASSERT_FALSE(table_data->is_static);
@@ -55,14 +61,14 @@ TEST_F(symbol_table_unit_test, variable_int_test) {
 
 TEST_F(symbol_table_unit_test, variable_float_test) {
   parser::ast::node::variable_t *p_var = new parser::ast::node::variable_t(
-      tok_float, 0, "another_var_name",
+      tok_float, 0, sym("another_var_name"),
       new parser::ast::node::literal_expr_t(tok_float, "2.8"));
 
   p_st->add(p_var);
 
   ASSERT_EQ(1, p_st->table.size());
   symbol_table::data_t *table_data;
-  table_data = p_st->table["another_var_name"];
+  table_data = p_st->table[sym("another_var_name")];
   ASSERT_EQ(tok_float, table_data->type);
   ASSERT_EQ(0, table_data->pointer_level);
   ASSERT_FALSE(table_data->is_static);
@@ -73,14 +79,14 @@ TEST_F(symbol_table_unit_test, variable_float_test) {
 
 TEST_F(symbol_table_unit_test, variable_char_test) {
   parser::ast::node::variable_t *p_var = new parser::ast::node::variable_t(
-      tok_char, 0, "var_name",
+      tok_char, 0, sym("var_name"),
       new parser::ast::node::literal_expr_t(tok_char, 'x'));
 
   p_st->add(p_var);
 
   ASSERT_EQ(1, p_st->table.size());
   symbol_table::data_t *table_data;
-  table_data = p_st->table["var_name"];
+  table_data = p_st->table[sym("var_name")];
   ASSERT_EQ(tok_char, table_data->type);
   ASSERT_EQ(0, table_data->pointer_level);
   ASSERT_FALSE(table_data->is_static);
@@ -91,14 +97,14 @@ TEST_F(symbol_table_unit_test, variable_char_test) {
 
 TEST_F(symbol_table_unit_test, variable_string_test) {
   parser::ast::node::variable_t *p_var = new parser::ast::node::variable_t(
-      tok_string, 0, "var_name",
+      tok_string, 0, sym("var_name"),
       new parser::ast::node::literal_expr_t(tok_string, "Hallo Welt!"));
 
   p_st->add(p_var);
 
   ASSERT_EQ(1, p_st->table.size());
   symbol_table::data_t *table_data;
-  table_data = p_st->table["var_name"];
+  table_data = p_st->table[sym("var_name")];
   ASSERT_EQ(tok_string, table_data->type);
   ASSERT_EQ(0, table_data->pointer_level);
   ASSERT_FALSE(table_data->is_static);
@@ -109,14 +115,14 @@ TEST_F(symbol_table_unit_test, variable_string_test) {
 
 TEST_F(symbol_table_unit_test, variable_pointer_test) {
   parser::ast::node::variable_t *p_var = new parser::ast::node::variable_t(
-      tok_char, 1, "var_name",
+      tok_char, 1, sym("var_name"),
       new parser::ast::node::literal_expr_t(tok_char_literal, "hallo"));
 
   p_st->add(p_var);
 
   ASSERT_EQ(1, p_st->table.size());
   symbol_table::data_t *table_data;
-  table_data = p_st->table["var_name"];
+  table_data = p_st->table[sym("var_name")];
   ASSERT_EQ(tok_char, table_data->type);
   ASSERT_EQ(1, table_data->pointer_level);
   ASSERT_FALSE(table_data->is_static);
@@ -127,14 +133,14 @@ TEST_F(symbol_table_unit_test, variable_pointer_test) {
 
 TEST_F(symbol_table_unit_test, variable_const_test) {
   parser::ast::node::variable_t *p_var = new parser::ast::node::variable_t(
-      tok_int, 0, "var_name",
+      tok_int, 0, sym("var_name"),
       new parser::ast::node::literal_expr_t(tok_int, 1), true, false);
 
   p_st->add(p_var);
 
   ASSERT_EQ(1, p_st->table.size());
   symbol_table::data_t *table_data;
-  table_data = p_st->table["var_name"];
+  table_data = p_st->table[sym("var_name")];
   ASSERT_EQ(tok_int, table_data->type);
   ASSERT_EQ(0, table_data->pointer_level);
   ASSERT_FALSE(table_data->is_static);
@@ -146,14 +152,14 @@ TEST_F(symbol_table_unit_test, variable_const_test) {
 
 TEST_F(symbol_table_unit_test, variable_static_test) {
   parser::ast::node::variable_t *p_var = new parser::ast::node::variable_t(
-      tok_int, 0, "var_name",
+      tok_int, 0, sym("var_name"),
       new parser::ast::node::literal_expr_t(tok_int, 1), false, true);
 
   p_st->add(p_var);
 
   ASSERT_EQ(1, p_st->table.size());
   symbol_table::data_t *table_data;
-  table_data = p_st->table["var_name"];
+  table_data = p_st->table[sym("var_name")];
   ASSERT_EQ(tok_int, table_data->type);
   ASSERT_EQ(0, table_data->pointer_level);
   ASSERT_TRUE(table_data->is_static);
@@ -164,14 +170,14 @@ TEST_F(symbol_table_unit_test, variable_static_test) {
 
 TEST_F(symbol_table_unit_test, variable_const_static_test) {
   parser::ast::node::variable_t *p_var = new parser::ast::node::variable_t(
-      tok_int, 0, "var_name",
+      tok_int, 0, sym("var_name"),
       new parser::ast::node::literal_expr_t(tok_int, 1), true, true);
 
   p_st->add(p_var);
 
   ASSERT_EQ(1, p_st->table.size());
   symbol_table::data_t *table_data;
-  table_data = p_st->table["var_name"];
+  table_data = p_st->table[sym("var_name")];
   ASSERT_EQ(tok_int, table_data->type);
   ASSERT_EQ(0, table_data->pointer_level);
   ASSERT_TRUE(table_data->is_static);
@@ -182,11 +188,11 @@ TEST_F(symbol_table_unit_test, variable_const_static_test) {
 
 TEST_F(symbol_table_unit_test, variable_double_declare_test) {
   parser::ast::node::variable_t *p_var = new parser::ast::node::variable_t(
-      tok_int, 0, "var_name",
+      tok_int, 0, sym("var_name"),
       new parser::ast::node::literal_expr_t(tok_int, 1));
 
   parser::ast::node::variable_t *p_var2 = new parser::ast::node::variable_t(
-      tok_string, 0, "var_name",
+      tok_string, 0, sym("var_name"),
       new parser::ast::node::literal_expr_t(tok_string, "Moin"));
 
   p_st->add(p_var);
@@ -195,38 +201,41 @@ TEST_F(symbol_table_unit_test, variable_double_declare_test) {
 
 TEST_F(symbol_table_unit_test, variable_assign_test) {
   parser::ast::node::variable_t *p_var = new parser::ast::node::variable_t(
-      tok_int, 0, "var_name",
+      tok_int, 0, sym("var_name"),
       new parser::ast::node::literal_expr_t(tok_int, 1));
 
   p_st->add(p_var);
   ASSERT_EQ(1, p_st->table.size());
   symbol_table::data_t *table_data;
-  table_data = p_st->table["var_name"];
+  table_data = p_st->table[sym("var_name")];
   ASSERT_EQ("(int 1)", table_data->get_expr()->to_prefix_notation());
 
   parser::ast::node::assign_expr_t *p_assign =
       new parser::ast::node::assign_expr_t(
-          "var_name", new parser::ast::node::literal_expr_t(tok_int, 2));
+          sym("var_name"), new parser::ast::node::literal_expr_t(tok_int, 2));
 
   p_st->assign(p_assign);
   ASSERT_EQ(1, p_st->table.size());
-  table_data = p_st->table["var_name"];
+  table_data = p_st->table[sym("var_name")];
   ASSERT_EQ("(int 2)", table_data->get_expr()->to_prefix_notation());
 }
 
 TEST_F(symbol_table_unit_test, function_test) {
-  parser::ast::node::function_t *p_func = new parser::ast::node::function_t(
-      tok_int, 0, "main",
-      new std::vector<std::tuple<token_e, int>>(
-          {std::tuple<token_e, int>(tok_int, 0),
-           std::tuple<token_e, int>(tok_int, 0)}),
-      new parser::ast::node::block_t());
+  arena_t arena;
+  auto *p_parameters =
+      arena.create<parser::ast::node::node_list_t<std::tuple<token_e, int>>>();
+  p_parameters->push_back(arena, std::tuple<token_e, int>(tok_int, 0));
+  p_parameters->push_back(arena, std::tuple<token_e, int>(tok_int, 0));
+  parser::ast::node::function_t *p_func =
+      arena.create<parser::ast::node::function_t>(
+          tok_int, 0, sym("main"), p_parameters,
+          arena.create<parser::ast::node::block_t>());
 
   p_st->add(p_func);
 
   ASSERT_EQ(1, p_st->table.size());
   symbol_table::data_t *table_data;
-  table_data = p_st->table["main"];
+  table_data = p_st->table[sym("main")];
   ASSERT_EQ(tok_int, table_data->type);
   ASSERT_EQ(0, table_data->pointer_level);
   ASSERT_FALSE(table_data->is_static);
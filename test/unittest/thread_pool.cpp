@@ -0,0 +1,43 @@
+#include "thread_pool.h"
+#include <atomic>
+#include <cstddef>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+
+using namespace compiler;
+
+class thread_pool_unit_test : public ::testing::Test {
+protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+TEST_F(thread_pool_unit_test, parallel_for_runs_every_task_once) {
+  for (size_t n_threads : {1, 2, 4}) {
+    thread_pool_t pool = thread_pool_t(n_threads);
+    EXPECT_EQ(n_threads, pool.size());
+
+    std::vector<std::atomic<int>> runs(1000);
+    pool.parallel_for(runs.size(), [&](size_t i) { runs[i]++; });
+    for (size_t i = 0; i < runs.size(); i++) {
+      EXPECT_EQ(1, runs[i].load()) << "task " << i;
+    }
+  }
+}
+
+TEST_F(thread_pool_unit_test, parallel_for_rethrows) {
+  thread_pool_t pool = thread_pool_t(3);
+  std::atomic<int> finished = 0;
+
+  EXPECT_THROW(pool.parallel_for(16,
+                                 [&](size_t i) {
+                                   if (i == 5) {
+                                     throw std::runtime_error("task failed");
+                                   }
+                                   finished++;
+                                 }),
+               std::runtime_error);
+  // the other tasks still ran to completion
+  EXPECT_EQ(15, finished.load());
+}
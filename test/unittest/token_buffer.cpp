@@ -0,0 +1,38 @@
+#include "token_buffer.h"
+#include "tokens.h"
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace compiler;
+
+class token_buffer_unit_test : public ::testing::Test {
+protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+TEST_F(token_buffer_unit_test, push_back_and_read) {
+  std::string source = "int x;\nx";
+  token_buffer_t tokens = token_buffer_t(source);
+
+  EXPECT_TRUE(tokens.empty());
+  EXPECT_EQ(0u, tokens.push_back(tok_int, 0, 3));
+  EXPECT_EQ(1u, tokens.push_back(tok_id, 4, 1));
+  EXPECT_EQ(2u, tokens.push_back(tok_semicolon, 5, 1));
+  EXPECT_EQ(3u, tokens.push_back(tok_id, 7, 1));
+  EXPECT_EQ(4u, tokens.push_back(tok_eof, 8, 0));
+
+  ASSERT_EQ(5u, tokens.size());
+  EXPECT_EQ(tok_int, tokens.kind(0));
+  EXPECT_EQ("int", tokens.text(0));
+  EXPECT_EQ(4u, tokens.offset(1));
+  EXPECT_EQ(1u, tokens.length(1));
+  EXPECT_EQ("", tokens.text(4));
+  EXPECT_EQ(tok_semicolon, static_cast<token_e>(tokens.kinds()[2]));
+
+  token_t tok = tokens.get(3);
+  EXPECT_EQ(tok_id, tok.e_tok_type);
+  EXPECT_EQ("x", tok.t_val);
+  EXPECT_EQ(7u, tok.offset);
+  EXPECT_EQ("<id, (x)>", debug_tok(tok));
+}
@@ -0,0 +1,95 @@
+#include "lexer/lexer.h"
+#include "lexer/token_cache.h"
+#include "source_buffer.h"
+#include "token_buffer.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace compiler;
+
+class token_cache_unit_test : public ::testing::Test {
+protected:
+  void SetUp() override {
+    this->t_directory = testing::TempDir() + "token_cache_test";
+    std::filesystem::remove_all(this->t_directory);
+  }
+  void TearDown() override { std::filesystem::remove_all(this->t_directory); }
+
+  std::string t_directory;
+};
+
+void expect_same_tokens(const token_buffer_t &expected,
+                        const token_buffer_t &actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (token_index_t i = 0; i < expected.size(); i++) {
+    EXPECT_EQ(expected.kind(i), actual.kind(i)) << "token " << i;
+    EXPECT_EQ(expected.offset(i), actual.offset(i)) << "token " << i;
+    EXPECT_EQ(expected.length(i), actual.length(i)) << "token " << i;
+    EXPECT_EQ(expected.value(i).integer, actual.value(i).integer)
+        << "token " << i;
+  }
+}
+
+TEST_F(token_cache_unit_test, content_hash_depends_on_every_byte) {
+  std::string text = std::string(100, 'a');
+  uint64_t h = lexer::content_hash(text);
+  EXPECT_EQ(h, lexer::content_hash(std::string(100, 'a')));
+  EXPECT_NE(h, lexer::content_hash(text, 1));
+  for (size_t i = 0; i < text.length(); i++) {
+    std::string changed = text;
+    changed[i] = 'b';
+    EXPECT_NE(h, lexer::content_hash(changed)) << "byte " << i;
+  }
+  EXPECT_NE(h, lexer::content_hash(std::string(101, 'a')));
+}
+
+TEST_F(token_cache_unit_test, store_then_load) {
+  lexer::token_cache_t cache = lexer::token_cache_t(this->t_directory);
+  std::string source = "int value = other + 42;\nvalue = 1.5 * value;\n";
+  lexer::lexer_t lxr;
+  token_buffer_t tokens = lxr.lex(source);
+
+  token_buffer_t loaded;
+  EXPECT_FALSE(cache.load(source, &loaded));
+  EXPECT_TRUE(cache.store(source, tokens));
+  ASSERT_TRUE(cache.load(source, &loaded));
+  expect_same_tokens(tokens, loaded);
+  EXPECT_EQ(source.data(), loaded.source().data());
+
+  // a different source with the same length misses
+  std::string edited = source;
+  edited[4] = 'V';
+  EXPECT_FALSE(cache.load(edited, &loaded));
+}
+
+TEST_F(token_cache_unit_test, damaged_entry_misses) {
+  lexer::token_cache_t cache = lexer::token_cache_t(this->t_directory);
+  std::string source = "int main() { return 0; }";
+  lexer::lexer_t lxr;
+  ASSERT_TRUE(cache.store(source, lxr.lex(source)));
+
+  std::filesystem::resize_file(cache.entry_path(source), 40);
+  token_buffer_t loaded;
+  EXPECT_FALSE(cache.load(source, &loaded));
+}
+
+TEST_F(token_cache_unit_test, lex_file_uses_cache) {
+  lexer::token_cache_t cache = lexer::token_cache_t(this->t_directory);
+  source_buffer_t source =
+      source_buffer_t::from_string("int half(int n) { return n / 2; }\n");
+
+  token_buffer_t first = lexer::lex_file(source, nullptr, &cache);
+  ASSERT_TRUE(std::filesystem::exists(cache.entry_path(source.view())));
+  token_buffer_t second = lexer::lex_file(source, nullptr, &cache);
+  expect_same_tokens(first, second);
+
+  // sources with errors are not cached, a hit would lose the diagnostics
+  source_buffer_t broken = source_buffer_t::from_string("int @ x;\n");
+  diagnostics_t diagnostics;
+  lexer::lex_file(broken, &diagnostics, &cache);
+  EXPECT_FALSE(diagnostics.empty());
+  EXPECT_FALSE(std::filesystem::exists(cache.entry_path(broken.view())));
+}
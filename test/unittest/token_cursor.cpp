@@ -0,0 +1,101 @@
+#include "lexer/lexer.h"
+#include "parser/token_cursor.h"
+#include "source_stream.h"
+#include "token_buffer.h"
+#include "tokens.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace compiler;
+using parser::token_checkpoint_t;
+using parser::token_cursor_t;
+
+class token_cursor_unit_test : public ::testing::Test {
+protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+static std::vector<std::string> drain(token_cursor_t &tokens) {
+  std::vector<std::string> lexemes;
+  while (tokens.peek_kind() != tok_eof) {
+    lexemes.emplace_back(tokens.advance().t_val);
+  }
+  return lexemes;
+}
+
+TEST_F(token_cursor_unit_test, rewind_over_buffer) {
+  std::string source = "a b c d e";
+  lexer::lexer_t lxr;
+  token_buffer_t buffer = lxr.lex(source);
+  token_cursor_t tokens = token_cursor_t(buffer);
+
+  tokens.advance();
+  token_checkpoint_t outer = tokens.checkpoint();
+  EXPECT_EQ("b", tokens.advance().t_val);
+  token_checkpoint_t inner = tokens.checkpoint();
+  tokens.advance();
+  tokens.advance();
+  tokens.rewind(inner);
+  EXPECT_EQ(2u, tokens.position());
+  EXPECT_EQ("c", tokens.peek().t_val);
+  tokens.rewind(outer);
+  EXPECT_EQ(1u, tokens.position());
+  EXPECT_EQ((std::vector<std::string>{"b", "c", "d", "e"}), drain(tokens));
+}
+
+TEST_F(token_cursor_unit_test, rewind_streaming_past_lookahead) {
+  std::string source;
+  for (int i = 0; i < 40; i++) {
+    source += "x" + std::to_string(i) + " ";
+  }
+  lexer::lexer_t reference;
+  token_buffer_t buffer = reference.lex(source);
+  token_cursor_t expected = token_cursor_t(buffer);
+
+  lexer::lexer_t lxr = lexer::lexer_t(source);
+  token_cursor_t tokens = token_cursor_t(lxr);
+  tokens.advance();
+  token_checkpoint_t cp = tokens.checkpoint();
+  for (size_t i = 0; i < 3 * lexer::lexer_t::max_lookahead; i++) {
+    tokens.advance();
+  }
+  tokens.rewind(cp);
+  EXPECT_EQ("x1", tokens.peek().t_val);
+  EXPECT_EQ("x2", tokens.peek(1).t_val);
+
+  // committing keeps the position and lets the cursor drop the history
+  cp = tokens.checkpoint();
+  EXPECT_EQ("x1", tokens.advance().t_val);
+  tokens.commit(cp);
+
+  expected.advance();
+  expected.advance();
+  EXPECT_EQ(drain(expected), drain(tokens));
+  EXPECT_EQ(tok_eof, tokens.advance().e_tok_type);
+}
+
+TEST_F(token_cursor_unit_test, replayed_lexemes_survive_refills) {
+  std::string source;
+  for (int i = 0; i < 30; i++) {
+    source += "name_" + std::to_string(i) + "\n";
+  }
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  ASSERT_EQ(static_cast<ssize_t>(source.length()),
+            write(fds[1], source.data(), source.length()));
+  close(fds[1]);
+
+  source_stream_t stream = source_stream_t(fds[0], 8);
+  lexer::lexer_t lxr = lexer::lexer_t(stream);
+  token_cursor_t tokens = token_cursor_t(lxr);
+  token_checkpoint_t cp = tokens.checkpoint();
+  std::vector<std::string> first = drain(tokens);
+  tokens.rewind(cp);
+  EXPECT_EQ(first, drain(tokens));
+  ASSERT_EQ(30u, first.size());
+  EXPECT_EQ("name_29", first.back());
+  close(fds[0]);
+}
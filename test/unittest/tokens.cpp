@@ -26,3 +26,17 @@ TEST_F(tokens_unit_test, debug_token_test) {
   expected = "<eof, ()>";
   EXPECT_EQ(expected, result);
 }
+
+TEST_F(tokens_unit_test, token_spec_test) {
+  static_assert(token_spec[tok_assign].left_precidence == 20);
+
+  EXPECT_EQ("float_literal", token_t(tok_float_literal, "1.5", 0).type_name());
+  EXPECT_EQ("char_literal", token_t(tok_char_literal, "'a'", 0).type_name());
+
+  // assignment groups to the right, arithmetic to the left
+  EXPECT_GT(get_left_precidence(tok_assign), get_right_precidence(tok_assign));
+  EXPECT_LT(get_left_precidence(tok_plus), get_right_precidence(tok_plus));
+  EXPECT_GT(get_left_precidence(tok_star), get_left_precidence(tok_plus));
+  EXPECT_EQ(0, get_left_precidence(tok_semicolon));
+  EXPECT_EQ(0, get_right_precidence(tok_semicolon));
+}